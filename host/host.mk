@@ -0,0 +1,57 @@
+# Copyright 2021 The CFU-Playground Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Host-native build of a lab, included from its Makefile after proj.mk.
+#
+#   make host                  build build-host/software for Linux
+#   make host-run              run it on the console
+#   make host-run HOST_KEYS=121
+#                              run it on these menu keys, e.g. "3b1\r" for a
+#                              menu key followed by a read_val() answer
+#   make host-clean
+#
+# The tree is build/src (the common sources and the TFLM tree, as the
+# firmware build last copied them), then shared/src for labs that include
+# shared.mk, then the lab's src/ overlay, then the shims in host/src for the
+# parts that touch hardware: perf.h, riscv.h and the console. Every CFU op
+# runs the lab's software_cfu(), so the kernels, kernel tests and layer
+# benchmarks run in seconds for correctness and relative speed. "Cycles" are
+# host nanoseconds: cycle counts still come from the simulator or the board.
+
+HOST_DIR       := $(abspath $(dir $(lastword $(MAKEFILE_LIST))))
+HOST_BUILD_DIR := $(abspath build-host)
+
+.PHONY: host host-run host-clean
+host:
+	@test -d build/src || { echo "build/src not found: build the firmware" \
+	  "once so that it holds the common sources"; exit 1; }
+	@mkdir -p $(HOST_BUILD_DIR)/src
+	@tar -C build/src --exclude='*.o' --exclude='*.d' -cf - . | \
+	  tar -C $(HOST_BUILD_DIR)/src -xf -
+ifdef SHARED_SRC_DIR
+	@tar -C $(SHARED_SRC_DIR) -cf - . | tar -C $(HOST_BUILD_DIR)/src -xf -
+endif
+	@tar -C src -cf - . | tar -C $(HOST_BUILD_DIR)/src -xf -
+	@tar -C $(HOST_DIR)/src -cf - . | tar -C $(HOST_BUILD_DIR)/src -xf -
+	$(MAKE) -C $(HOST_BUILD_DIR) -f $(HOST_DIR)/Makefile DEFINES="$(DEFINES)"
+
+host-run: host
+ifdef HOST_KEYS
+	printf '$(HOST_KEYS)' | $(HOST_BUILD_DIR)/software
+else
+	$(HOST_BUILD_DIR)/software
+endif
+
+host-clean:
+	rm -rf $(HOST_BUILD_DIR)
@@ -0,0 +1,3 @@
+// LiteX generates soc.h for the SoC. The host build has no SoC: it defines
+// nothing, so code behind #ifdef CSR_..., CONFIG_... and ..._BASE drops out.
+#pragma once
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include "base.h"
+#include "functional_cfu_tests.h"
+#include "menu.h"
+#include "playground_util/util_tests.h"
+#include "proj_menu.h"
+#include "tflite_unit_tests.h"
+#include "third_party/embench_iot_v1/embench.h"
+#ifndef SKIP_TFLM
+#include "models/models.h"
+#endif
+
+// main.c for the host build (host/host.mk): the items of the main menu that
+// need no hardware, under the same keys.
+static struct Menu MENU = {
+    "CFU Playground",
+    "main",
+    {
+#ifndef SKIP_TFLM
+        MENU_ITEM('1', "TfLM Models menu", models_menu),
+#endif
+        MENU_ITEM('2', "Functional CFU Tests", do_functional_cfu_tests),
+        MENU_ITEM('3', "Project menu", do_proj_menu),
+#ifndef SKIP_TFLM
+        MENU_ITEM('5', "TFLite Unit Tests", tflite_do_tests),
+#endif
+        MENU_ITEM('7', "Util Tests", do_util_tests_menu),
+        MENU_ITEM('8', "Embench IoT", embench_menu),
+        MENU_SENTINEL,
+    },
+};
+
+int main(void) {
+  init_runtime();
+  printf("Hello, %s!\n", "World");
+  printf("Host build: CFU ops run software_cfu() and \"cycles\" are "
+         "nanoseconds.\n");
+
+  menu_run(&MENU);
+
+  return (0);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CFU_PLAYGROUND_PERF_H_
+#define CFU_PLAYGROUND_PERF_H_
+
+// perf.h for the host build (host/host.mk). There are no perf counter CSRs,
+// and mcycle counts nanoseconds of CLOCK_MONOTONIC, so "cycles" printed by a
+// host build are host time, only good for comparing two host runs.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_PERF_COUNTERS 0
+
+extern unsigned CFU_start_counts[NUM_PERF_COUNTERS];
+extern unsigned CFU_counter_high[NUM_PERF_COUNTERS];
+extern unsigned CFU_counter_last[NUM_PERF_COUNTERS];
+
+static inline void perf_zero_start_counts() {}
+
+static inline unsigned perf_get_start_count(int counter_num) { return 0; }
+
+static inline uint64_t perf_get_mcycle64() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static inline unsigned perf_get_mcycle() {
+  return (unsigned)perf_get_mcycle64();
+}
+
+// As on boards without a writable mcycle, callers take differences instead.
+static inline void perf_set_mcycle(unsigned cyc) {}
+
+static inline unsigned perf_get_counter(int counter_num) { return 0; }
+
+static inline unsigned perf_get_counter_enable(int counter_num) { return 0; }
+
+static inline void perf_set_counter(int counter_num, unsigned count) {}
+
+static inline void perf_sample_counter(int counter_num) {}
+
+static inline uint64_t perf_get_counter64(int counter_num) { return 0; }
+
+static inline void perf_set_counter_enable(int counter_num, unsigned en) {}
+
+static inline void perf_enable_counter(int counter_num) {}
+
+static inline void perf_disable_counter(int counter_num) {}
+
+// Print a human readable number (useful for perf counters)
+void perf_print_human(uint64_t n);
+
+// Print a value in both human readable and precise forms (also useful for perf
+// counters)
+void perf_print_value(uint64_t n);
+
+// Set each individual perf counter to zero
+void perf_reset_all_counters();
+
+// Prints cycle and enable counts for every perf coutner
+void perf_print_all_counters();
+
+// Test menu
+void perf_test_menu(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // CFU_PLAYGROUND_PERF_H_
@@ -0,0 +1,30 @@
+// Copyright 2021 The CFU-Playground Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// riscv.h for the host build (host/host.mk).
+
+#include "software_cfu.h"
+
+// There is no CFU to encode a custom instruction for: cfu_op*_hw() runs the
+// project's software_cfu() like cfu_op*_sw() does.
+#define opcode_R(opcode, func3, func7, rs1, rs2) \
+  software_cfu((func3), (func7), (rs1), (rs2))
+
+// No CSRs either. Reads return 0 and writes are dropped.
+#define csr_read(csr) (0ul)
+#define csr_write(csr, val) ((void)(val))
+#define csr_set(csr, val) ((void)(val))
+#define csr_clear(csr, val) ((void)(val))
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Console for the host build (host/host.mk): stdin and stdout. The menus
+   never return, so the end of input ends the program, which lets a session
+   be scripted, e.g. printf '12x' | build-host/software. */
+
+char readchar(void)
+{
+  fflush(stdout);
+  int c = getchar();
+  if (c == EOF) {
+    putchar('\n');
+    exit(0);
+  }
+  return (char) c;
+}
+
+void putsnonl(const char *s)
+{
+  fputs(s, stdout);
+}
@@ -17,11 +17,31 @@
 #include <stdint.h>
 #include "software_cfu.h"
 
+// Software model of the CFU in cfu.v, a 4-way int8 multiply-accumulate.
 //
-// In this function, place C code to emulate your CFU. You can switch between
-// hardware and emulated CFU by setting the CFU_SOFTWARE_DEFINED DEFINE in
-// the Makefile.
-uint32_t software_cfu(int funct3, int funct7, uint32_t rs1, uint32_t rs2)
-{
-  return (funct3 & 1) ? rs2 : rs1;
+// Any nonzero funct7 (cmd_payload_function_id[9:3]) clears the accumulator.
+// funct7 0 adds the four products of rs1 bytes plus the input offset of 128
+// with the signed rs2 bytes. Both return the new accumulator, and funct3 is
+// ignored just like in cfu.v.
+
+namespace {
+
+int32_t acc;
+
+int32_t byte_at(uint32_t word, int lane) {
+  return static_cast<int8_t>(word >> (8 * lane));
+}
+
+}  // anonymous namespace
+
+uint32_t software_cfu(int funct3, int funct7, uint32_t rs1, uint32_t rs2) {
+  (void)funct3;
+  if (funct7) {
+    acc = 0;
+    return acc;
+  }
+  for (int lane = 0; lane < 4; ++lane) {
+    acc += (byte_at(rs1, lane) + 128) * byte_at(rs2, lane);
+  }
+  return acc;
 }
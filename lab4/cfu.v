@@ -15,7 +15,21 @@ module Cfu (
 
   // assign rsp_valid = cmd_valid;
   // assign cmd_ready = rsp_ready;
-    assign cmd_ready = ~rsp_valid;
+  // cmd_ready is assigned below, next to the busy flags of the sequential
+  // units.
+  //
+  // funct7  0  combined_exponential_reciprocal_approx (single cycle)
+  //         1  exp_on_negative_values (EXP_LAST_STEP cycles)
+  //         2  softmax load sum: in0 = sum of exps (Q12.19), in1 = output
+  //            bits (8 or 16); latches the reciprocal and output shift
+  //            (RECIP_LAST_STEP cycles), returns the reciprocal
+  //         3  softmax normalize: in0 = exp (Q0.31), returns the saturated
+  //            output for the sum latched by funct7 = 2 (single cycle)
+  //         4  int16 sigmoid setup: in0 = input multiplier, in1[4:0] =
+  //            input shift, in1[5] = tanh instead of logistic (single cycle)
+  //         5  int16 Logistic/Tanh of a pair: in0 = two int16 inputs, returns
+  //            the two int16 outputs for the setup latched by funct7 = 4
+  //            (SIGMOID_LAST_STEP cycles)
 
 
   // Combined function for exp(x) and reciprocal
@@ -36,36 +50,449 @@ module Cfu (
     end
   endfunction
 
-  function [31:0] softmax_approx(input [31:0] x);
-      begin
-          case (x)
-              32'hfcccccce : softmax_approx = 32'h39839c8b;  
-              32'hfd99999b : softmax_approx = 32'h463f75c8; 
-              32'hfe666667 : softmax_approx = 32'h55cd0c27; 
-              32'hff333334 : softmax_approx = 32'h68cc2b93; 
-              32'h00000000 : softmax_approx = 32'h7fffffff; 
-              32'hfecccccd : softmax_approx = 32'h5ed3218f; 
-              32'hff99999a : softmax_approx = 32'h73d1b674; 
-              default: softmax_approx = 32'h00000000;       // Default case for unmatched inputs
-          endcase
+  // ---------------------------------------------------------------------
+  // exp_on_negative_values: Q5.26 in, Q0.31 out, bit-exact with
+  // gemmlowp::exp_on_negative_values<int32_t, 5>.
+  //
+  // The same sequence of SaturatingRoundingDoublingHighMul steps as gemmlowp
+  // is run through one shared multiplier, one step per cycle:
+  //   1..3   x^2, x^3, x^4 of the Taylor expansion around -1/8
+  //   4..5   polynomial and the exp(-1/8) scaling
+  //   6..12  barrel shifter, multiply by exp(-2^k) for k = -2..4
+  // ---------------------------------------------------------------------
+  localparam [31:0] EXP_ONE_QUARTER = 32'h01000000;   // 1/4 in Q5.26
+  localparam [31:0] EXP_ONE_EIGHTH  = 32'h10000000;   // 1/8 in Q0.31
+  localparam [31:0] EXP_MINUS_EIGHTH = 32'd1895147668; // exp(-1/8) in Q0.31
+  localparam [31:0] ONE_THIRD       = 32'd715827883;  // 1/3 in Q0.31
+  localparam [3:0]  EXP_LAST_STEP   = 4'd12;
+
+  function signed [31:0] srdhm(input signed [31:0] a, input signed [31:0] b);
+    reg signed [63:0] ab;
+    reg signed [63:0] ab_nudged;
+    reg signed [63:0] quotient;
+    begin
+      ab = a * b;
+      ab_nudged = ab + (ab >= 0 ? 64'sd1073741824 : -64'sd1073741823);
+      // Divide by 2^31 rounding towards zero, as C++ integer division does.
+      quotient = ab_nudged >>> 31;
+      if (ab_nudged < 0 && ab_nudged[30:0] != 0)
+        quotient = quotient + 1;
+      srdhm = (a == 32'h80000000 && b == 32'h80000000) ? 32'h7fffffff
+                                                        : quotient[31:0];
+    end
+  endfunction
+
+  function signed [31:0] rounding_divide_by_pot(input signed [31:0] x,
+                                                input [4:0] exponent);
+    reg [31:0] mask;
+    reg [31:0] remainder;
+    reg [31:0] threshold;
+    begin
+      mask = (32'd1 << exponent) - 32'd1;
+      remainder = x & mask;
+      threshold = (mask >> 1) + {31'd0, x[31]};
+      rounding_divide_by_pot = (x >>> exponent) +
+                               ((remainder > threshold) ? 32'sd1 : 32'sd0);
+    end
+  endfunction
+
+  // x << exponent, saturated: gemmlowp::SaturatingRoundingMultiplyByPOT.
+  function signed [31:0] saturating_shift_left(input signed [31:0] x,
+                                               input [1:0] exponent);
+    reg signed [31:0] threshold;
+    begin
+      threshold = (32'sd1 <<< (5'd31 - exponent)) - 32'sd1;
+      if (x > threshold)
+        saturating_shift_left = 32'h7fffffff;
+      else if (x < -threshold)
+        saturating_shift_left = 32'h80000000;
+      else
+        saturating_shift_left = x <<< exponent;
+    end
+  endfunction
+
+  function [5:0] count_leading_zeros(input [31:0] x);
+    integer i;
+    begin
+      count_leading_zeros = 6'd32;
+      for (i = 0; i < 32; i = i + 1)
+        if (x[i])
+          count_leading_zeros = 6'd31 - i;
+    end
+  endfunction
+
+  function [31:0] exp_barrel_multiplier(input [3:0] step);
+    case (step)
+      4'd6:    exp_barrel_multiplier = 32'd1672461947;  // exp(-1/4)
+      4'd7:    exp_barrel_multiplier = 32'd1302514674;  // exp(-1/2)
+      4'd8:    exp_barrel_multiplier = 32'd790015084;   // exp(-1)
+      4'd9:    exp_barrel_multiplier = 32'd290630308;   // exp(-2)
+      4'd10:   exp_barrel_multiplier = 32'd39332535;    // exp(-4)
+      4'd11:   exp_barrel_multiplier = 32'd720401;      // exp(-8)
+      default: exp_barrel_multiplier = 32'd242;         // exp(-16)
+    endcase
+  endfunction
+
+  // ---------------------------------------------------------------------
+  // Softmax normalization, bit-exact with tflite::GetReciprocal followed by
+  // RoundingDivideByPOT(SRDHM(scale, exp), shift) and saturation to OutputT.
+  //
+  // Load sum runs gemmlowp::one_over_one_plus_x_for_x_in_0_1 through the
+  // shared multiplier:
+  //   1      x = 48/17 - 32/17 * half_denominator
+  //   2..7   three Newton-Raphson iterations, two multiplies each
+  // ---------------------------------------------------------------------
+  localparam [31:0] RECIP_48_OVER_17     = 32'd1515870810;   // Q2.29
+  localparam [31:0] RECIP_NEG_32_OVER_17 = -32'd1010580540;  // Q2.29
+  localparam [31:0] RECIP_ONE            = 32'h20000000;     // 1.0 in Q2.29
+  localparam [2:0]  RECIP_LAST_STEP      = 3'd7;
+  localparam [5:0]  SOFTMAX_SHIFT_BASE   = 6'd43;  // 12 integer bits + 31
+
+  reg               recip_busy;
+  reg        [2:0]  recip_step;
+  reg        [31:0] recip_half_denominator;
+  reg        [31:0] recip_x;
+  reg        [31:0] recip_t;
+  reg        [31:0] recip_scale;
+  reg        [5:0]  recip_shift;
+  reg signed [31:0] norm_out_min, norm_out_max;
+
+  wire [5:0]  sum_headroom = count_leading_zeros(cmd_payload_inputs_0);
+  wire [31:0] sum_shifted = cmd_payload_inputs_0 << sum_headroom;
+
+  // ---------------------------------------------------------------------
+  // int16 Logistic and Tanh, bit-exact with reference_integer_ops::Logistic
+  // and Tanh for int16: scale the input, interpolate between two entries of
+  // sigmoid_table_uint16 and fix up the sign. Both lanes are scaled when the
+  // command is accepted, then the table is read once per lane:
+  //   1      read lane 0's two entries
+  //   2      interpolate lane 0, read lane 1's two entries
+  //   3      interpolate lane 1 and answer
+  // ---------------------------------------------------------------------
+  localparam [1:0] SIGMOID_LAST_STEP = 2'd3;
+
+  reg [15:0] sigmoid_table [0:255];
+  initial begin
+    sigmoid_table[0] = 16'd32768; sigmoid_table[1] = 16'd33451; sigmoid_table[2] = 16'd34133;
+    sigmoid_table[3] = 16'd34813; sigmoid_table[4] = 16'd35493; sigmoid_table[5] = 16'd36169;
+    sigmoid_table[6] = 16'd36843; sigmoid_table[7] = 16'd37513; sigmoid_table[8] = 16'd38180;
+    sigmoid_table[9] = 16'd38841; sigmoid_table[10] = 16'd39498; sigmoid_table[11] = 16'd40149;
+    sigmoid_table[12] = 16'd40794; sigmoid_table[13] = 16'd41432; sigmoid_table[14] = 16'd42064;
+    sigmoid_table[15] = 16'd42688; sigmoid_table[16] = 16'd43304; sigmoid_table[17] = 16'd43912;
+    sigmoid_table[18] = 16'd44511; sigmoid_table[19] = 16'd45102; sigmoid_table[20] = 16'd45683;
+    sigmoid_table[21] = 16'd46255; sigmoid_table[22] = 16'd46817; sigmoid_table[23] = 16'd47369;
+    sigmoid_table[24] = 16'd47911; sigmoid_table[25] = 16'd48443; sigmoid_table[26] = 16'd48964;
+    sigmoid_table[27] = 16'd49475; sigmoid_table[28] = 16'd49975; sigmoid_table[29] = 16'd50464;
+    sigmoid_table[30] = 16'd50942; sigmoid_table[31] = 16'd51409; sigmoid_table[32] = 16'd51865;
+    sigmoid_table[33] = 16'd52311; sigmoid_table[34] = 16'd52745; sigmoid_table[35] = 16'd53169;
+    sigmoid_table[36] = 16'd53581; sigmoid_table[37] = 16'd53983; sigmoid_table[38] = 16'd54374;
+    sigmoid_table[39] = 16'd54755; sigmoid_table[40] = 16'd55125; sigmoid_table[41] = 16'd55485;
+    sigmoid_table[42] = 16'd55834; sigmoid_table[43] = 16'd56174; sigmoid_table[44] = 16'd56503;
+    sigmoid_table[45] = 16'd56823; sigmoid_table[46] = 16'd57133; sigmoid_table[47] = 16'd57433;
+    sigmoid_table[48] = 16'd57724; sigmoid_table[49] = 16'd58007; sigmoid_table[50] = 16'd58280;
+    sigmoid_table[51] = 16'd58544; sigmoid_table[52] = 16'd58800; sigmoid_table[53] = 16'd59048;
+    sigmoid_table[54] = 16'd59288; sigmoid_table[55] = 16'd59519; sigmoid_table[56] = 16'd59743;
+    sigmoid_table[57] = 16'd59959; sigmoid_table[58] = 16'd60168; sigmoid_table[59] = 16'd60370;
+    sigmoid_table[60] = 16'd60565; sigmoid_table[61] = 16'd60753; sigmoid_table[62] = 16'd60935;
+    sigmoid_table[63] = 16'd61110; sigmoid_table[64] = 16'd61279; sigmoid_table[65] = 16'd61441;
+    sigmoid_table[66] = 16'd61599; sigmoid_table[67] = 16'd61750; sigmoid_table[68] = 16'd61896;
+    sigmoid_table[69] = 16'd62036; sigmoid_table[70] = 16'd62172; sigmoid_table[71] = 16'd62302;
+    sigmoid_table[72] = 16'd62428; sigmoid_table[73] = 16'd62549; sigmoid_table[74] = 16'd62666;
+    sigmoid_table[75] = 16'd62778; sigmoid_table[76] = 16'd62886; sigmoid_table[77] = 16'd62990;
+    sigmoid_table[78] = 16'd63090; sigmoid_table[79] = 16'd63186; sigmoid_table[80] = 16'd63279;
+    sigmoid_table[81] = 16'd63368; sigmoid_table[82] = 16'd63454; sigmoid_table[83] = 16'd63536;
+    sigmoid_table[84] = 16'd63615; sigmoid_table[85] = 16'd63691; sigmoid_table[86] = 16'd63765;
+    sigmoid_table[87] = 16'd63835; sigmoid_table[88] = 16'd63903; sigmoid_table[89] = 16'd63968;
+    sigmoid_table[90] = 16'd64030; sigmoid_table[91] = 16'd64090; sigmoid_table[92] = 16'd64148;
+    sigmoid_table[93] = 16'd64204; sigmoid_table[94] = 16'd64257; sigmoid_table[95] = 16'd64308;
+    sigmoid_table[96] = 16'd64357; sigmoid_table[97] = 16'd64405; sigmoid_table[98] = 16'd64450;
+    sigmoid_table[99] = 16'd64494; sigmoid_table[100] = 16'd64536; sigmoid_table[101] = 16'd64576;
+    sigmoid_table[102] = 16'd64614; sigmoid_table[103] = 16'd64652; sigmoid_table[104] = 16'd64687;
+    sigmoid_table[105] = 16'd64721; sigmoid_table[106] = 16'd64754; sigmoid_table[107] = 16'd64786;
+    sigmoid_table[108] = 16'd64816; sigmoid_table[109] = 16'd64845; sigmoid_table[110] = 16'd64873;
+    sigmoid_table[111] = 16'd64900; sigmoid_table[112] = 16'd64926; sigmoid_table[113] = 16'd64950;
+    sigmoid_table[114] = 16'd64974; sigmoid_table[115] = 16'd64997; sigmoid_table[116] = 16'd65019;
+    sigmoid_table[117] = 16'd65039; sigmoid_table[118] = 16'd65060; sigmoid_table[119] = 16'd65079;
+    sigmoid_table[120] = 16'd65097; sigmoid_table[121] = 16'd65115; sigmoid_table[122] = 16'd65132;
+    sigmoid_table[123] = 16'd65149; sigmoid_table[124] = 16'd65164; sigmoid_table[125] = 16'd65179;
+    sigmoid_table[126] = 16'd65194; sigmoid_table[127] = 16'd65208; sigmoid_table[128] = 16'd65221;
+    sigmoid_table[129] = 16'd65234; sigmoid_table[130] = 16'd65246; sigmoid_table[131] = 16'd65258;
+    sigmoid_table[132] = 16'd65269; sigmoid_table[133] = 16'd65280; sigmoid_table[134] = 16'd65291;
+    sigmoid_table[135] = 16'd65301; sigmoid_table[136] = 16'd65310; sigmoid_table[137] = 16'd65319;
+    sigmoid_table[138] = 16'd65328; sigmoid_table[139] = 16'd65337; sigmoid_table[140] = 16'd65345;
+    sigmoid_table[141] = 16'd65352; sigmoid_table[142] = 16'd65360; sigmoid_table[143] = 16'd65367;
+    sigmoid_table[144] = 16'd65374; sigmoid_table[145] = 16'd65381; sigmoid_table[146] = 16'd65387;
+    sigmoid_table[147] = 16'd65393; sigmoid_table[148] = 16'd65399; sigmoid_table[149] = 16'd65404;
+    sigmoid_table[150] = 16'd65410; sigmoid_table[151] = 16'd65415; sigmoid_table[152] = 16'd65420;
+    sigmoid_table[153] = 16'd65425; sigmoid_table[154] = 16'd65429; sigmoid_table[155] = 16'd65433;
+    sigmoid_table[156] = 16'd65438; sigmoid_table[157] = 16'd65442; sigmoid_table[158] = 16'd65445;
+    sigmoid_table[159] = 16'd65449; sigmoid_table[160] = 16'd65453; sigmoid_table[161] = 16'd65456;
+    sigmoid_table[162] = 16'd65459; sigmoid_table[163] = 16'd65462; sigmoid_table[164] = 16'd65465;
+    sigmoid_table[165] = 16'd65468; sigmoid_table[166] = 16'd65471; sigmoid_table[167] = 16'd65474;
+    sigmoid_table[168] = 16'd65476; sigmoid_table[169] = 16'd65479; sigmoid_table[170] = 16'd65481;
+    sigmoid_table[171] = 16'd65483; sigmoid_table[172] = 16'd65485; sigmoid_table[173] = 16'd65488;
+    sigmoid_table[174] = 16'd65489; sigmoid_table[175] = 16'd65491; sigmoid_table[176] = 16'd65493;
+    sigmoid_table[177] = 16'd65495; sigmoid_table[178] = 16'd65497; sigmoid_table[179] = 16'd65498;
+    sigmoid_table[180] = 16'd65500; sigmoid_table[181] = 16'd65501; sigmoid_table[182] = 16'd65503;
+    sigmoid_table[183] = 16'd65504; sigmoid_table[184] = 16'd65505; sigmoid_table[185] = 16'd65507;
+    sigmoid_table[186] = 16'd65508; sigmoid_table[187] = 16'd65509; sigmoid_table[188] = 16'd65510;
+    sigmoid_table[189] = 16'd65511; sigmoid_table[190] = 16'd65512; sigmoid_table[191] = 16'd65513;
+    sigmoid_table[192] = 16'd65514; sigmoid_table[193] = 16'd65515; sigmoid_table[194] = 16'd65516;
+    sigmoid_table[195] = 16'd65517; sigmoid_table[196] = 16'd65517; sigmoid_table[197] = 16'd65518;
+    sigmoid_table[198] = 16'd65519; sigmoid_table[199] = 16'd65520; sigmoid_table[200] = 16'd65520;
+    sigmoid_table[201] = 16'd65521; sigmoid_table[202] = 16'd65522; sigmoid_table[203] = 16'd65522;
+    sigmoid_table[204] = 16'd65523; sigmoid_table[205] = 16'd65523; sigmoid_table[206] = 16'd65524;
+    sigmoid_table[207] = 16'd65524; sigmoid_table[208] = 16'd65525; sigmoid_table[209] = 16'd65525;
+    sigmoid_table[210] = 16'd65526; sigmoid_table[211] = 16'd65526; sigmoid_table[212] = 16'd65526;
+    sigmoid_table[213] = 16'd65527; sigmoid_table[214] = 16'd65527; sigmoid_table[215] = 16'd65528;
+    sigmoid_table[216] = 16'd65528; sigmoid_table[217] = 16'd65528; sigmoid_table[218] = 16'd65529;
+    sigmoid_table[219] = 16'd65529; sigmoid_table[220] = 16'd65529; sigmoid_table[221] = 16'd65529;
+    sigmoid_table[222] = 16'd65530; sigmoid_table[223] = 16'd65530; sigmoid_table[224] = 16'd65530;
+    sigmoid_table[225] = 16'd65530; sigmoid_table[226] = 16'd65531; sigmoid_table[227] = 16'd65531;
+    sigmoid_table[228] = 16'd65531; sigmoid_table[229] = 16'd65531; sigmoid_table[230] = 16'd65531;
+    sigmoid_table[231] = 16'd65532; sigmoid_table[232] = 16'd65532; sigmoid_table[233] = 16'd65532;
+    sigmoid_table[234] = 16'd65532; sigmoid_table[235] = 16'd65532; sigmoid_table[236] = 16'd65532;
+    sigmoid_table[237] = 16'd65533; sigmoid_table[238] = 16'd65533; sigmoid_table[239] = 16'd65533;
+    sigmoid_table[240] = 16'd65533; sigmoid_table[241] = 16'd65533; sigmoid_table[242] = 16'd65533;
+    sigmoid_table[243] = 16'd65533; sigmoid_table[244] = 16'd65533; sigmoid_table[245] = 16'd65534;
+    sigmoid_table[246] = 16'd65534; sigmoid_table[247] = 16'd65534; sigmoid_table[248] = 16'd65534;
+    sigmoid_table[249] = 16'd65534; sigmoid_table[250] = 16'd65534; sigmoid_table[251] = 16'd65534;
+    sigmoid_table[252] = 16'd65534; sigmoid_table[253] = 16'd65534; sigmoid_table[254] = 16'd65534;
+    sigmoid_table[255] = 16'd65535;
+  end
+
+  reg               sigmoid_busy;
+  reg        [1:0]  sigmoid_step;
+  reg signed [31:0] sigmoid_multiplier;
+  reg        [4:0]  sigmoid_shift;
+  reg               sigmoid_tanh;
+  reg signed [31:0] sigmoid_x0, sigmoid_x1;
+  reg        [15:0] sigmoid_ua, sigmoid_ub;
+  reg        [15:0] sigmoid_out0;
+
+  // (x * multiplier + round) >> shift, as the kernels scale their inputs.
+  function signed [31:0] sigmoid_scale(input signed [15:0] x);
+    reg signed [31:0] round;
+    begin
+      round = (sigmoid_shift != 5'd0) ? (32'sd1 <<< (sigmoid_shift - 5'd1))
+                                      : 32'sd0;
+      sigmoid_scale = (x * sigmoid_multiplier + round) >>> sigmoid_shift;
+    end
+  endfunction
+
+  function [31:0] sigmoid_abs(input signed [31:0] x);
+    sigmoid_abs = x[31] ? -x : x;
+  endfunction
+
+  // Table index of a scaled input; saturated inputs read entry 0, unused.
+  function [7:0] sigmoid_index(input signed [31:0] x, input tanh);
+    reg [31:0] uh;
+    begin
+      uh = tanh ? sigmoid_abs(x) >> 8 : sigmoid_abs(x) >> 9;
+      sigmoid_index = (uh >= 32'd255) ? 8'd0 : uh[7:0];
+    end
+  endfunction
+
+  function [15:0] sigmoid_interpolate(input signed [31:0] x,
+                                      input [15:0] ua, input [15:0] ub,
+                                      input tanh);
+    reg [31:0] ax;
+    reg [31:0] result;
+    begin
+      ax = sigmoid_abs(x);
+      if (tanh) begin
+        result = (ax >> 8 >= 32'd255) ? (32'hffff << 8)
+                                      : ({16'd0, ua} << 8) + ax[7:0] * (ub - ua);
+        result = x[31] ? (32'd1 << 23) + (32'd1 << 7) - 32'd1 - result
+                       : result - (32'd1 << 23) + (32'd1 << 7);
+        sigmoid_interpolate = result[23:8];
+      end else begin
+        result = (ax >> 9 >= 32'd255) ? (32'h7fff << 10)
+                                      : ({16'd0, ua} << 9) + ax[8:0] * (ub - ua);
+        result = x[31] ? (32'd1 << 25) - result + (32'd1 << 9) - 32'd1
+                       : result + (32'd1 << 9);
+        sigmoid_interpolate = result[25:10];
       end
+    end
   endfunction
 
+  // Table index of the lane read in the current step.
+  wire [7:0] sigmoid_lane_index =
+      sigmoid_index(sigmoid_step == 2'd1 ? sigmoid_x0 : sigmoid_x1,
+                    sigmoid_tanh);
+
+  reg        exp_busy;
+  reg [3:0]  exp_step;
+  reg [31:0] exp_in;
+  reg [31:0] exp_x, exp_x2, exp_x3;
+  reg [31:0] exp_acc;
+  reg [31:0] exp_remainder;
+
+  assign cmd_ready = ~rsp_valid & ~exp_busy & ~recip_busy & ~sigmoid_busy;
+
+  wire [31:0] exp_a_mod = (cmd_payload_inputs_0 & (EXP_ONE_QUARTER - 1))
+                          - EXP_ONE_QUARTER;
+
+  // One SaturatingRoundingDoublingHighMul shared by the exp and reciprocal
+  // sequences; while both are idle it serves the normalize op.
+  reg  [31:0] mul_a, mul_b;
+  wire [31:0] mul = srdhm(mul_a, mul_b);
+
+  always @(*) begin
+    if (recip_busy) begin
+      case (recip_step)
+        3'd1:    begin mul_a = recip_half_denominator; mul_b = RECIP_NEG_32_OVER_17; end
+        3'd2,
+        3'd4,
+        3'd6:    begin mul_a = recip_half_denominator; mul_b = recip_x; end
+        default: begin mul_a = recip_x; mul_b = recip_t; end
+      endcase
+    end else if (exp_busy) begin
+      case (exp_step)
+        4'd1:    begin mul_a = exp_x;  mul_b = exp_x;  end
+        4'd2:    begin mul_a = exp_x2; mul_b = exp_x;  end
+        4'd3:    begin mul_a = exp_x2; mul_b = exp_x2; end
+        4'd4:    begin mul_a = exp_acc; mul_b = ONE_THIRD; end
+        4'd5:    begin
+          mul_a = EXP_MINUS_EIGHTH;
+          mul_b = exp_x + rounding_divide_by_pot(exp_acc, 5'd1);
+        end
+        default: begin
+          mul_a = exp_acc;
+          mul_b = exp_barrel_multiplier(exp_step);
+        end
+      endcase
+    end else begin
+      mul_a = recip_scale;
+      mul_b = cmd_payload_inputs_0;
+    end
+  end
+
+  wire [31:0] recip_x_next = recip_x + saturating_shift_left(mul, 2'd2);
+
+  wire signed [31:0] norm_unsat =
+      rounding_divide_by_pot(mul, recip_shift[4:0]) + norm_out_min;
+  wire [31:0] norm_out = (norm_unsat > norm_out_max) ? norm_out_max :
+                         (norm_unsat < norm_out_min) ? norm_out_min :
+                                                       norm_unsat;
+
   always @(posedge clk) begin
     if (reset) begin
         rsp_payload_outputs_0 <= 32'b0;
         rsp_valid <= 1'b0;
+        exp_busy <= 1'b0;
+        exp_step <= 4'd0;
+        recip_busy <= 1'b0;
+        recip_step <= 3'd0;
+        sigmoid_busy <= 1'b0;
+        sigmoid_step <= 2'd0;
     end else if (rsp_valid) begin
         // Waiting to hand off response to CPU.
         rsp_valid <= ~rsp_ready;
+    end else if (recip_busy) begin
+        case (recip_step)
+          3'd1:    recip_x <= RECIP_48_OVER_17 + mul;
+          3'd2,
+          3'd4,
+          3'd6:    recip_t <= RECIP_ONE - mul;
+          default: recip_x <= recip_x_next;
+        endcase
+        recip_step <= recip_step + 3'd1;
+        if (recip_step == RECIP_LAST_STEP) begin
+          recip_busy <= 1'b0;
+          recip_scale <= saturating_shift_left(recip_x_next, 2'd1);
+          rsp_valid <= 1'b1;
+          rsp_payload_outputs_0 <= saturating_shift_left(recip_x_next, 2'd1);
+        end
+    end else if (sigmoid_busy) begin
+        case (sigmoid_step)
+          2'd1: begin
+            sigmoid_ua <= sigmoid_table[sigmoid_lane_index];
+            sigmoid_ub <= sigmoid_table[sigmoid_lane_index + 8'd1];
+          end
+          2'd2: begin
+            sigmoid_out0 <= sigmoid_interpolate(sigmoid_x0, sigmoid_ua,
+                                                sigmoid_ub, sigmoid_tanh);
+            sigmoid_ua <= sigmoid_table[sigmoid_lane_index];
+            sigmoid_ub <= sigmoid_table[sigmoid_lane_index + 8'd1];
+          end
+          SIGMOID_LAST_STEP: begin
+            sigmoid_busy <= 1'b0;
+            rsp_valid <= 1'b1;
+            rsp_payload_outputs_0 <= {
+                sigmoid_interpolate(sigmoid_x1, sigmoid_ua, sigmoid_ub,
+                                    sigmoid_tanh),
+                sigmoid_out0};
+          end
+        endcase
+        sigmoid_step <= sigmoid_step + 2'd1;
+    end else if (exp_busy) begin
+        case (exp_step)
+          4'd1: exp_x2 <= mul;
+          4'd2: exp_x3 <= mul;
+          4'd3: exp_acc <= rounding_divide_by_pot(mul, 5'd2) + exp_x3;
+          4'd4: exp_acc <= mul + exp_x2;
+          4'd5: exp_acc <= EXP_MINUS_EIGHTH + mul;
+          default:
+            if (exp_remainder[exp_step + 5'd18])
+              exp_acc <= mul;
+        endcase
+        exp_step <= exp_step + 4'd1;
+        if (exp_step == EXP_LAST_STEP) begin
+          exp_busy <= 1'b0;
+          rsp_valid <= 1'b1;
+          // exp(0) is exactly one; the barrel shifter result is used otherwise.
+          if (exp_in == 32'd0)
+            rsp_payload_outputs_0 <= 32'h7fffffff;
+          else
+            rsp_payload_outputs_0 <= exp_remainder[30] ? mul : exp_acc;
+        end
     end else if (cmd_valid) begin
-        rsp_valid <= 1'b1;
-        // Accumulate step:
-        rsp_payload_outputs_0 <= |cmd_payload_function_id[9:3]
-            ? softmax_approx(cmd_payload_inputs_0)
-            : combined_exponential_reciprocal_approx(cmd_payload_inputs_0);      
+        case (cmd_payload_function_id[9:3])
+          7'd0: begin
+            rsp_valid <= 1'b1;
+            rsp_payload_outputs_0 <=
+                combined_exponential_reciprocal_approx(cmd_payload_inputs_0);
+          end
+          7'd2: begin
+            // GetReciprocal: the sum is normalized to [1, 2) and its
+            // fractional part x turned into half_denominator = (1 + x) / 2.
+            recip_busy <= 1'b1;
+            recip_step <= 3'd1;
+            recip_half_denominator <= {2'b01, sum_shifted[30:1]};
+            recip_shift <= SOFTMAX_SHIFT_BASE - sum_headroom
+                           - cmd_payload_inputs_1[5:0];
+            norm_out_min <= -(32'sd1 <<< (cmd_payload_inputs_1[4:0] - 5'd1));
+            norm_out_max <= (32'sd1 <<< (cmd_payload_inputs_1[4:0] - 5'd1))
+                            - 32'sd1;
+          end
+          7'd3: begin
+            rsp_valid <= 1'b1;
+            rsp_payload_outputs_0 <= norm_out;
+          end
+          7'd4: begin
+            rsp_valid <= 1'b1;
+            rsp_payload_outputs_0 <= 32'b0;
+            sigmoid_multiplier <= cmd_payload_inputs_0;
+            sigmoid_shift <= cmd_payload_inputs_1[4:0];
+            sigmoid_tanh <= cmd_payload_inputs_1[5];
+          end
+          7'd5: begin
+            sigmoid_busy <= 1'b1;
+            sigmoid_step <= 2'd1;
+            sigmoid_x0 <= sigmoid_scale(cmd_payload_inputs_0[15:0]);
+            sigmoid_x1 <= sigmoid_scale(cmd_payload_inputs_0[31:16]);
+          end
+          default: begin
+            // exp_on_negative_values, answered after EXP_LAST_STEP cycles.
+            exp_busy <= 1'b1;
+            exp_step <= 4'd1;
+            exp_in <= cmd_payload_inputs_0;
+            exp_x <= (exp_a_mod << 5) + EXP_ONE_EIGHTH;
+            exp_remainder <= exp_a_mod - cmd_payload_inputs_0;
+          end
+        endcase
     end
   end
 
 endmodule
-
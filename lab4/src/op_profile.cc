@@ -0,0 +1,463 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "op_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace {
+
+// Op types are few in practice; events with more distinct tags than this are
+// left out of the per type table.
+constexpr int kMaxOpTypes = 64;
+
+// Tag of nodes whose work a fused node took over, and the prefix of the fused
+// ops themselves (see kernels/graph_rewrite.h).
+const char* const kAbsorbedTag = "FUSED_PART";
+const char* const kFusedPrefix = "FUSED_";
+
+struct OpTypeTotals {
+  const char* tag;
+  int nodes;
+  uint64_t cycles;
+  uint64_t macs;
+};
+
+OpTypeTotals op_types[kMaxOpTypes];
+const TraceEvent* node_events[TracingProfiler::kMaxEvents];
+
+uint64_t tensor_elements(const tflite::Tensor* tensor) {
+  uint64_t elements = 1;
+  if (tensor->shape() != nullptr) {
+    for (int32_t dim : *tensor->shape()) {
+      elements *= dim;
+    }
+  }
+  return elements;
+}
+
+// Dimension |i| of |tensor|, counting from the end for negative |i|; 0 if it
+// has no such dimension.
+uint64_t tensor_dim(const tflite::Tensor* tensor, int i) {
+  const int rank = tensor->shape() == nullptr ? 0 : tensor->shape()->size();
+  if (i < 0) {
+    i += rank;
+  }
+  return i >= 0 && i < rank ? tensor->shape()->Get(i) : 0;
+}
+
+void print_share(uint64_t part, uint64_t total) {
+  const uint64_t permille = total ? (part * 1000 + total / 2) / total : 0;
+  printf(" %3llu.%llu%%", permille / 10, permille % 10);
+}
+
+// Prints |num| / |den| with two decimals, or "-" when either is 0.
+void print_ratio(uint64_t num, uint64_t den, int width) {
+  if (num == 0 || den == 0) {
+    printf(" %*s", width, "-");
+    return;
+  }
+  const uint64_t centi = num * 100 / den;
+  printf(" %*llu.%02llu", width - 3, centi / 100, centi % 100);
+}
+
+void print_row(uint64_t cycles, uint64_t total_cycles, uint64_t macs) {
+  printf(" | %12llu |", cycles);
+  print_share(cycles, total_cycles);
+  printf(" | %12llu |", macs);
+  print_ratio(macs, cycles, 8);
+  printf("\n");
+}
+
+// MACs charged to node |op_index|, which ran as |tag|. Absorbed nodes run
+// nothing, so their MACs wait in |absorbed_macs| for the next fused node,
+// which does their work.
+uint64_t charged_macs(const tflite::Model* model, int op_index,
+                      const char* tag, uint64_t* absorbed_macs) {
+  uint64_t macs = op_profile_macs(model, op_index);
+  if (strcmp(tag, kAbsorbedTag) == 0) {
+    *absorbed_macs += macs;
+    return 0;
+  }
+  if (strncmp(tag, kFusedPrefix, strlen(kFusedPrefix)) == 0) {
+    macs += *absorbed_macs;
+    *absorbed_macs = 0;
+  }
+  return macs;
+}
+
+// Collects the outermost events of |profiler|, one per node that ran, into
+// node_events; events nested inside a node's are part of its cycles already.
+int collect_node_events(const TracingProfiler& profiler) {
+  int num_events = 0;
+  for (int i = 0; i < profiler.num_events(); ++i) {
+    if (profiler.event(i).depth == 0) {
+      node_events[num_events++] = &profiler.event(i);
+    }
+  }
+  return num_events;
+}
+
+int num_nodes(const tflite::Model* model) {
+  const auto* operators = model->subgraphs()->Get(0)->operators();
+  return operators == nullptr ? 0 : static_cast<int>(operators->size());
+}
+
+// Whether node_events holds one event per node of |model|, in node order.
+bool events_match_nodes(const tflite::Model* model,
+                        const TracingProfiler& profiler, int num_events) {
+  return profiler.num_dropped() == 0 && num_events > 0 &&
+         num_events == num_nodes(model);
+}
+
+int type_bytes(tflite::TensorType type) {
+  switch (type) {
+    case tflite::TensorType_INT8:
+    case tflite::TensorType_UINT8:
+    case tflite::TensorType_BOOL:
+      return 1;
+    case tflite::TensorType_INT16:
+    case tflite::TensorType_FLOAT16:
+      return 2;
+    case tflite::TensorType_INT64:
+    case tflite::TensorType_FLOAT64:
+      return 8;
+    default:
+      return 4;
+  }
+}
+
+uint64_t tensor_bytes(const tflite::Tensor* tensor) {
+  return tensor_elements(tensor) * type_bytes(tensor->type());
+}
+
+// Whether |tensor| is stored in the model, like weights and biases.
+bool is_constant(const tflite::Model* model, const tflite::Tensor* tensor) {
+  const auto* buffers = model->buffers();
+  if (buffers == nullptr || tensor->buffer() >= buffers->size()) {
+    return false;
+  }
+  const auto* data = buffers->Get(tensor->buffer())->data();
+  return data != nullptr && data->size() > 0;
+}
+
+// Writes the shape of |tensor| as "1x32x32x16" into |buf|.
+void format_dims(const tflite::Tensor* tensor, char* buf, int size) {
+  int used = snprintf(buf, size, "-");
+  if (tensor == nullptr || tensor->shape() == nullptr) {
+    return;
+  }
+  used = 0;
+  for (int32_t dim : *tensor->shape()) {
+    if (used >= size) {
+      break;
+    }
+    used += snprintf(buf + used, size - used, used ? "x%ld" : "%ld",
+                     static_cast<long>(dim));
+  }
+}
+
+// Writes the window of a convolution or pooling as "3x3/2" (height x width /
+// stride) into |buf|, or "-" for other ops.
+void format_window(const tflite::Model* model, const tflite::Operator* op,
+                   char* buf, int size) {
+  const auto* tensors = model->subgraphs()->Get(0)->tensors();
+  auto filter_dim = [&](int i) {
+    return static_cast<long>(
+        tensor_dim(tensors->Get(op->inputs()->Get(1)), i));
+  };
+  switch (tflite::GetBuiltinCode(
+      model->operator_codes()->Get(op->opcode_index()))) {
+    case tflite::BuiltinOperator_CONV_2D:
+      if (const auto* options = op->builtin_options_as_Conv2DOptions()) {
+        snprintf(buf, size, "%ldx%ld/%ld", filter_dim(1), filter_dim(2),
+                 static_cast<long>(options->stride_h()));
+        return;
+      }
+      break;
+    case tflite::BuiltinOperator_DEPTHWISE_CONV_2D:
+      if (const auto* options =
+              op->builtin_options_as_DepthwiseConv2DOptions()) {
+        snprintf(buf, size, "%ldx%ld/%ld", filter_dim(1), filter_dim(2),
+                 static_cast<long>(options->stride_h()));
+        return;
+      }
+      break;
+    case tflite::BuiltinOperator_TRANSPOSE_CONV:
+      if (const auto* options = op->builtin_options_as_TransposeConvOptions()) {
+        snprintf(buf, size, "%ldx%ld/%ld", filter_dim(1), filter_dim(2),
+                 static_cast<long>(options->stride_h()));
+        return;
+      }
+      break;
+    case tflite::BuiltinOperator_AVERAGE_POOL_2D:
+    case tflite::BuiltinOperator_MAX_POOL_2D:
+      if (const auto* options = op->builtin_options_as_Pool2DOptions()) {
+        snprintf(buf, size, "%ldx%ld/%ld",
+                 static_cast<long>(options->filter_height()),
+                 static_cast<long>(options->filter_width()),
+                 static_cast<long>(options->stride_h()));
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  snprintf(buf, size, "-");
+}
+
+// Prints the scale and zero point of |tensor|, the first channel's and a "*"
+// when quantized per channel.
+void print_quantization(const tflite::Tensor* tensor) {
+  const auto* quantization = tensor->quantization();
+  if (quantization == nullptr || quantization->scale() == nullptr ||
+      quantization->scale()->size() == 0) {
+    printf(" %-19s", "-");
+    return;
+  }
+  // No floats in printf here, so the scale is printed in millionths.
+  const uint32_t micro =
+      static_cast<uint32_t>(quantization->scale()->Get(0) * 1000000.0f + 0.5f);
+  const long zero_point =
+      quantization->zero_point() != nullptr &&
+              quantization->zero_point()->size() > 0
+          ? static_cast<long>(quantization->zero_point()->Get(0))
+          : 0;
+  printf(" %3lu.%06lu %4ld%c ", static_cast<unsigned long>(micro / 1000000),
+         static_cast<unsigned long>(micro % 1000000), zero_point,
+         quantization->scale()->size() > 1 ? '*' : ' ');
+}
+
+}  // anonymous namespace
+
+uint64_t op_profile_macs(const tflite::Model* model, int op_index) {
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  const tflite::Operator* op = subgraph->operators()->Get(op_index);
+  const auto* tensors = subgraph->tensors();
+  auto input = [&](int i) { return tensors->Get(op->inputs()->Get(i)); };
+  auto output = [&](int i) { return tensors->Get(op->outputs()->Get(i)); };
+
+  switch (tflite::GetBuiltinCode(
+      model->operator_codes()->Get(op->opcode_index()))) {
+    case tflite::BuiltinOperator_CONV_2D:
+      // Filter is [out_channels, height, width, in_channels].
+      return tensor_elements(output(0)) * tensor_dim(input(1), 1) *
+             tensor_dim(input(1), 2) * tensor_dim(input(1), 3);
+    case tflite::BuiltinOperator_DEPTHWISE_CONV_2D:
+      // Filter is [1, height, width, out_channels].
+      return tensor_elements(output(0)) * tensor_dim(input(1), 1) *
+             tensor_dim(input(1), 2);
+    case tflite::BuiltinOperator_TRANSPOSE_CONV:
+      // Every input element is scattered through the whole filter.
+      return tensor_elements(input(2)) * tensor_dim(input(1), 0) *
+             tensor_dim(input(1), 1) * tensor_dim(input(1), 2);
+    case tflite::BuiltinOperator_FULLY_CONNECTED:
+      // Weights are [units, depth].
+      return tensor_elements(output(0)) * tensor_dim(input(1), -1);
+    case tflite::BuiltinOperator_BATCH_MATMUL: {
+      const auto* options = op->builtin_options_as_BatchMatMulOptions();
+      const bool adj_x = options != nullptr && options->adj_x();
+      return tensor_elements(output(0)) * tensor_dim(input(0), adj_x ? -2 : -1);
+    }
+    default:
+      return 0;
+  }
+}
+
+void op_profile_print(const tflite::Model* model,
+                      const TracingProfiler& profiler) {
+  const int num_events = collect_node_events(profiler);
+  const bool per_node = events_match_nodes(model, profiler, num_events);
+  if (!per_node) {
+    printf("%d events (%u dropped) for %d nodes: no MAC counts or per node "
+           "table\n",
+           num_events, profiler.num_dropped(), num_nodes(model));
+  }
+
+  uint64_t total_cycles = 0;
+  uint64_t total_macs = 0;
+  uint64_t absorbed_macs = 0;
+  int num_types = 0;
+  for (int i = 0; i < num_events; ++i) {
+    const TraceEvent& event = *node_events[i];
+    const uint64_t macs =
+        per_node ? charged_macs(model, i, event.tag, &absorbed_macs) : 0;
+    total_cycles += event.cycles();
+    total_macs += macs;
+
+    int type = 0;
+    while (type < num_types && strcmp(op_types[type].tag, event.tag) != 0) {
+      ++type;
+    }
+    if (type == kMaxOpTypes) {
+      continue;
+    }
+    if (type == num_types) {
+      op_types[num_types++] = {event.tag, 0, 0, 0};
+    }
+    op_types[type].nodes++;
+    op_types[type].cycles += event.cycles();
+    op_types[type].macs += macs;
+  }
+
+  // Most expensive op type first.
+  for (int i = 1; i < num_types; ++i) {
+    const OpTypeTotals totals = op_types[i];
+    int j = i;
+    for (; j > 0 && op_types[j - 1].cycles < totals.cycles; --j) {
+      op_types[j] = op_types[j - 1];
+    }
+    op_types[j] = totals;
+  }
+
+  printf("\n Op type              | Nodes |       Cycles |  Share |"
+         "         MACs | MACs/cycle\n");
+  printf("----------------------+-------+--------------+--------+"
+         "--------------+-----------\n");
+  for (int i = 0; i < num_types; ++i) {
+    printf(" %-20s | %5d", op_types[i].tag, op_types[i].nodes);
+    print_row(op_types[i].cycles, total_cycles, op_types[i].macs);
+  }
+  printf(" %-20s | %5d", "total", num_events);
+  print_row(total_cycles, total_cycles, total_macs);
+
+  if (!per_node) {
+    return;
+  }
+  printf("\n Node | Op type              |       Cycles |  Share |"
+         "         MACs | MACs/cycle\n");
+  printf("------+----------------------+--------------+--------+"
+         "--------------+-----------\n");
+  absorbed_macs = 0;
+  for (int i = 0; i < num_events; ++i) {
+    const TraceEvent& event = *node_events[i];
+    const uint64_t macs = charged_macs(model, i, event.tag, &absorbed_macs);
+    printf(" %4d | %-20s", i, event.tag);
+    print_row(event.cycles(), total_cycles, macs);
+  }
+}
+
+void op_profile_print_layers(const tflite::Model* model,
+                             const TracingProfiler& profiler) {
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  const auto* tensors = subgraph->tensors();
+  const int num_events = collect_node_events(profiler);
+  const bool measured = events_match_nodes(model, profiler, num_events);
+
+  printf("\n Node | Op type              | Input            |"
+         " Output           | Window | Out scale  zp   |         MACs |"
+         "  Act bytes |  Wgt bytes | MACs/B");
+  if (measured) {
+    printf(" | Ran as               |       Cycles | MACs/cycle");
+  }
+  printf("\n");
+
+  uint64_t total_macs = 0;
+  uint64_t total_bytes = 0;
+  uint64_t total_cycles = 0;
+  uint64_t absorbed_macs = 0;
+  uint64_t best_macs = 0;
+  uint64_t best_cycles = 0;
+  int best_node = -1;
+  for (int i = 0; i < num_nodes(model); ++i) {
+    const tflite::Operator* op = subgraph->operators()->Get(i);
+    const tflite::OperatorCode* code =
+        model->operator_codes()->Get(op->opcode_index());
+    const tflite::BuiltinOperator builtin = tflite::GetBuiltinCode(code);
+
+    // Activations are what the node reads and writes in the arena, weights
+    // what it reads from the model.
+    const tflite::Tensor* input = nullptr;
+    uint64_t activation_bytes = 0;
+    uint64_t weight_bytes = 0;
+    for (int32_t index : *op->inputs()) {
+      if (index < 0) {
+        continue;
+      }
+      const tflite::Tensor* tensor = tensors->Get(index);
+      if (is_constant(model, tensor)) {
+        weight_bytes += tensor_bytes(tensor);
+      } else {
+        activation_bytes += tensor_bytes(tensor);
+        if (input == nullptr) {
+          input = tensor;
+        }
+      }
+    }
+    const tflite::Tensor* output = tensors->Get(op->outputs()->Get(0));
+    for (int32_t index : *op->outputs()) {
+      activation_bytes += tensor_bytes(tensors->Get(index));
+    }
+    const uint64_t macs = op_profile_macs(model, i);
+    total_macs += macs;
+    total_bytes += activation_bytes + weight_bytes;
+
+    char input_dims[24];
+    char output_dims[24];
+    char window[16];
+    format_dims(input, input_dims, sizeof(input_dims));
+    format_dims(output, output_dims, sizeof(output_dims));
+    format_window(model, op, window, sizeof(window));
+    printf(" %4d | %-20s | %-16s | %-16s | %-6s |", i,
+           builtin == tflite::BuiltinOperator_CUSTOM &&
+                   code->custom_code() != nullptr
+               ? code->custom_code()->c_str()
+               : tflite::EnumNameBuiltinOperator(builtin),
+           input_dims, output_dims, window);
+    print_quantization(output);
+    printf("| %12llu | %10llu | %10llu |", macs, activation_bytes,
+           weight_bytes);
+    print_ratio(macs, activation_bytes + weight_bytes, 6);
+
+    if (measured) {
+      // MACs of absorbed nodes are charged to the fused node that did them.
+      const TraceEvent& event = *node_events[i];
+      const uint64_t charged =
+          charged_macs(model, i, event.tag, &absorbed_macs);
+      total_cycles += event.cycles();
+      printf(" | %-20s | %12llu |", event.tag, event.cycles());
+      print_ratio(charged, event.cycles(), 10);
+      if (charged > 0 && event.cycles() > 0 &&
+          (best_node < 0 ||
+           charged * best_cycles > best_macs * event.cycles())) {
+        best_macs = charged;
+        best_cycles = event.cycles();
+        best_node = i;
+      }
+    }
+    printf("\n");
+  }
+
+  printf("\n%llu MACs over %llu bytes:", total_macs, total_bytes);
+  print_ratio(total_macs, total_bytes, 4);
+  printf(" MACs/byte\n");
+  if (measured) {
+    printf("%llu cycles:", total_cycles);
+    print_ratio(total_macs, total_cycles, 4);
+    printf(" MACs/cycle achieved overall");
+    if (best_node >= 0) {
+      printf(",");
+      print_ratio(best_macs, best_cycles, 4);
+      printf(" at best (node %d)", best_node);
+    }
+    printf("\n");
+  } else {
+    printf("Run an inference first for cycles and MACs/cycle per layer\n");
+  }
+}
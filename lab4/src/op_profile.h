@@ -0,0 +1,50 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Attributes the cycles of one inference to op types and nodes
+ */
+#include <stdint.h>
+
+#ifndef _OP_PROFILE_H
+#define _OP_PROFILE_H
+
+#ifndef __cplusplus
+#error "op_profile.h is for C++ only"
+#endif
+
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tracing_profiler.h"
+
+// Theoretical multiply-accumulates of operator |op_index| in the main subgraph
+// of |model|, from its tensor shapes. 0 for ops other than convolutions,
+// fully connected layers and batch matmuls.
+uint64_t op_profile_macs(const tflite::Model* model, int op_index);
+
+// Prints cycles, share of the total and MACs/cycle per op type, then per node,
+// from the outermost events of |profiler|. These must be one per node of the
+// main subgraph, none dropped, for the per node table and the MAC counts.
+void op_profile_print(const tflite::Model* model,
+                      const TracingProfiler& profiler);
+
+// Prints each node of the main subgraph of |model| with its op, input and
+// output shapes, window, output quantization, MACs, activation and weight
+// bytes and MACs per byte. When |profiler| holds one event per node, as after
+// an inference, also the op that ran, its cycles and MACs/cycle achieved.
+void op_profile_print_layers(const tflite::Model* model,
+                             const TracingProfiler& profiler);
+
+#endif  // _OP_PROFILE_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "output_checksum.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "playground_util/murmurhash.h"
+#include "tensorflow/lite/micro/kernels/graph_rewrite.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+// One output of one node. Outputs of absorbed nodes have |tensor| -1.
+struct Checksum {
+  int node;
+  int tensor;
+  uint32_t bytes;
+  uint32_t hash;
+};
+
+constexpr int kMaxChecksums = 1024;
+
+tflite::MicroGraph* graph = nullptr;
+Checksum checksums[kMaxChecksums];
+int num_checksums = 0;
+// Outputs past kMaxChecksums, not hashed.
+int num_dropped = 0;
+
+void add(const Checksum& checksum) {
+  if (num_checksums < kMaxChecksums) {
+    checksums[num_checksums++] = checksum;
+  } else {
+    ++num_dropped;
+  }
+}
+
+const tflite::NodeAndRegistration& node_and_registration(int node) {
+  return graph->GetAllocations()[0].node_and_registrations[node];
+}
+
+const char* op_name(const TfLiteRegistration* registration) {
+  if (registration->builtin_code == tflite::BuiltinOperator_CUSTOM) {
+    return registration->custom_name;
+  }
+  return tflite::EnumNameBuiltinOperator(
+      static_cast<tflite::BuiltinOperator>(registration->builtin_code));
+}
+
+}  // anonymous namespace
+
+void output_checksum_reset(tflite::MicroGraph* new_graph) {
+  graph = new_graph;
+  num_checksums = 0;
+  num_dropped = 0;
+}
+
+void output_checksum_node(int node) {
+  if (graph == nullptr || node < 0 ||
+      node >= static_cast<int>(graph->NumOperators(0))) {
+    return;
+  }
+  const tflite::NodeAndRegistration& nr = node_and_registration(node);
+  // Its outputs were dropped from the memory plan and never written.
+  if (nr.registration == tflite::micro::AbsorbedRegistration()) {
+    add({node, -1, 0, 0});
+    return;
+  }
+  const TfLiteIntArray* outputs = nr.node.outputs;
+  for (int i = 0; i < outputs->size; ++i) {
+    const int tensor = outputs->data[i];
+    if (tensor < 0) {
+      continue;
+    }
+    const TfLiteEvalTensor* eval_tensor =
+        &graph->GetAllocations()[0].tensors[tensor];
+    size_t bytes = 0;
+    if (eval_tensor->data.data == nullptr ||
+        tflite::TfLiteEvalTensorByteLength(eval_tensor, &bytes) != kTfLiteOk) {
+      bytes = 0;
+    }
+    const uint32_t hash = static_cast<uint32_t>(murmurhash3_32(
+        static_cast<const uint8_t*>(eval_tensor->data.data), bytes));
+    add({node, tensor, static_cast<uint32_t>(bytes), hash});
+  }
+}
+
+void output_checksum_print() {
+  printf("\n" OUTPUT_CHECKSUM_BEGIN "\n");
+  printf("\"Node\",\"Op\",\"Tensor\",\"Bytes\",\"Murmur3\"\n");
+  for (int i = 0; i < num_checksums; ++i) {
+    const Checksum& checksum = checksums[i];
+    const char* op =
+        graph != nullptr
+            ? op_name(node_and_registration(checksum.node).registration)
+            : "?";
+    if (checksum.tensor < 0) {
+      printf("%d,%s,-,-,-\n", checksum.node, op);
+    } else {
+      printf("%d,%s,%d,%lu,%08lx\n", checksum.node, op, checksum.tensor,
+             static_cast<unsigned long>(checksum.bytes),
+             static_cast<unsigned long>(checksum.hash));
+    }
+  }
+  if (num_dropped > 0) {
+    printf("%d outputs over the limit of %d were not hashed\n", num_dropped,
+           kMaxChecksums);
+  }
+  printf(OUTPUT_CHECKSUM_END "\n");
+}
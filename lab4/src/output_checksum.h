@@ -0,0 +1,48 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Murmur3 checksums of what every node of an inference wrote
+ */
+#ifndef _OUTPUT_CHECKSUM_H
+#define _OUTPUT_CHECKSUM_H
+
+#ifndef __cplusplus
+#error "output_checksum.h is for C++ only"
+#endif
+
+#include "tensorflow/lite/micro/micro_graph.h"
+
+// Lines around the checksums on the console. Compare two captured sessions,
+// e.g. a CFU build against a CFU_SOFTWARE_DEFINED one, with
+//   scripts/compare_checksums.py reference.log test.log
+#define OUTPUT_CHECKSUM_BEGIN "--- OUTPUT CHECKSUMS BEGIN ---"
+#define OUTPUT_CHECKSUM_END "--- OUTPUT CHECKSUMS END ---"
+
+// Forgets the checksums of the last inference. The nodes hashed next are
+// those of the first subgraph of |graph|.
+void output_checksum_reset(tflite::MicroGraph* graph);
+
+// Hashes each output tensor of node |node| as it stands, so must be called as
+// the node ends, before a later node reuses its memory. Fits
+// TracingProfiler::set_node_end_hook().
+void output_checksum_node(int node);
+
+// Prints node, op, tensor index, size and murmurhash3_32 of every output
+// hashed since the reset. Nodes fused into another print "-" for all three.
+void output_checksum_print();
+
+#endif  // _OUTPUT_CHECKSUM_H
@@ -28,6 +28,12 @@
 
 extern int logistic_test(int argc, char** argv);
 extern int softmax_test(int argc, char** argv);
+extern int batch_matmul_test(int argc, char** argv);
+extern int transpose_test(int argc, char** argv);
+extern int fused_attention_test(int argc, char** argv);
+extern int fused_swish_test(int argc, char** argv);
+extern int fused_layer_norm_test(int argc, char** argv);
+extern void tflite_print_layers();
 
 namespace {
 
@@ -41,12 +47,49 @@ void run_softmax_test() {
     softmax_test(0, NULL);
 }
 
+void run_batch_matmul_test() {
+    puts("BATCH_MATMUL TEST:");
+    batch_matmul_test(0, NULL);
+}
+
+void run_transpose_test() {
+    puts("TRANSPOSE TEST:");
+    transpose_test(0, NULL);
+}
+
+void run_fused_attention_test() {
+    puts("FUSED_ATTENTION TEST:");
+    fused_attention_test(0, NULL);
+}
+
+void run_fused_swish_test() {
+    puts("FUSED_SWISH TEST:");
+    fused_swish_test(0, NULL);
+}
+
+void run_fused_layer_norm_test() {
+    puts("FUSED LAYER NORM TEST:");
+    fused_layer_norm_test(0, NULL);
+}
+
+void print_layers() {
+    puts("\nLAYERS:");
+    tflite_print_layers();
+}
+
 struct Menu MENU = {
     "Project Menu",
     "project",
     {
         MENU_ITEM('1', "Run logistic tests", run_logistic_test),
         MENU_ITEM('2', "Run softmax tests", run_softmax_test),
+        MENU_ITEM('3', "Print layers of the loaded model", print_layers),
+        MENU_ITEM('4', "Run batch matmul tests", run_batch_matmul_test),
+        MENU_ITEM('5', "Run transpose tests", run_transpose_test),
+        MENU_ITEM('6', "Run fused attention tests", run_fused_attention_test),
+        MENU_ITEM('7', "Run fused swish tests", run_fused_swish_test),
+        MENU_ITEM('8', "Run fused layer norm tests",
+                  run_fused_layer_norm_test),
         MENU_END,
     },
 };
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include "software_cfu.h"
+
+#include "fixedpoint/fixedpoint.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+
+// Software model of the CFU in cfu.v.
+//
+// The op number is funct7 (cmd_payload_function_id[9:3]); funct3 is ignored
+// just like in cfu.v.
+//
+//    0  combined_exponential_reciprocal_approx(rs1)
+//    1  exp_on_negative_values(rs1), Q5.26 in, Q0.31 out
+//    2  softmax load sum: rs1 = sum of exps, rs2 = output bits; latches the
+//       reciprocal, output shift and output range, returns the reciprocal
+//    3  softmax normalize of exp rs1 for the sum latched by op 2
+//    4  int16 sigmoid setup: rs1 = input multiplier, rs2[4:0] = input shift,
+//       rs2[5] = tanh instead of logistic
+//    5  int16 Logistic/Tanh of the pair of int16 inputs in rs1
+//
+// Any other op runs exp_on_negative_values, as the default branch of cfu.v
+// does. The exp, reciprocal and sigmoid sequences are bit-exact with gemmlowp
+// and the reference kernels, so they are computed with those here rather than
+// step by step.
+
+namespace {
+
+// Latched by op 2.
+int32_t recip_scale;
+int recip_shift;
+int32_t norm_out_min, norm_out_max;
+
+// Latched by op 4.
+int32_t sigmoid_multiplier;
+int sigmoid_shift;
+bool sigmoid_tanh;
+
+int32_t srdhm(int32_t a, int32_t b) {
+  return gemmlowp::SaturatingRoundingDoublingHighMul(a, b);
+}
+
+// x << exponent, saturated: gemmlowp::SaturatingRoundingMultiplyByPOT.
+int32_t saturating_shift_left(int32_t x, int exponent) {
+  const int32_t threshold = (INT32_C(1) << (31 - exponent)) - 1;
+  if (x > threshold) return INT32_MAX;
+  if (x < -threshold) return INT32_MIN;
+  return static_cast<int32_t>(static_cast<uint32_t>(x) << exponent);
+}
+
+// Single cycle in cfu.v, all in unsigned 32-bit arithmetic.
+uint32_t combined_exponential_reciprocal_approx(uint32_t x) {
+  const uint32_t x_squared = (x * x) >> 16;
+  const uint32_t x_cubed = (x_squared * x) >> 16;
+  const uint32_t exp_result =
+      (1u << 16) + x + (x_squared >> 1) + x_cubed / 6;
+  uint32_t reciprocal_approx = 1u << 16;
+  reciprocal_approx =
+      reciprocal_approx *
+      ((2u << 16) - ((exp_result * reciprocal_approx) >> 16)) >> 16;
+  return reciprocal_approx;
+}
+
+uint32_t exp_on_negative_values(uint32_t x) {
+  // The explicit template arguments pick the generic gemmlowp version, not
+  // the fixedpoint.h overload that calls back into the CFU.
+  return gemmlowp::exp_on_negative_values<std::int32_t, 5>(
+             gemmlowp::FixedPoint<std::int32_t, 5>::FromRaw(x))
+      .raw();
+}
+
+// GetReciprocal: one_over_one_plus_x_for_x_in_0_1 of the sum normalized to
+// [1, 2), three Newton-Raphson iterations.
+uint32_t softmax_load_sum(uint32_t sum, uint32_t bits) {
+  const int headroom = sum == 0 ? 32 : __builtin_clz(sum);
+  const uint32_t shifted = headroom == 32 ? 0 : sum << headroom;
+  const int32_t half_denominator =
+      static_cast<int32_t>((1u << 30) | ((shifted >> 1) & 0x3fffffff));
+  int32_t x = 1515870810 + srdhm(half_denominator, -1010580540);
+  for (int i = 0; i < 3; ++i) {
+    const int32_t t = (1 << 29) - srdhm(half_denominator, x);
+    x = x + saturating_shift_left(srdhm(x, t), 2);
+  }
+  recip_scale = saturating_shift_left(x, 1);
+  recip_shift = (43 - headroom - static_cast<int>(bits & 63)) & 31;
+  const int out_bits = bits & 31;
+  norm_out_min = -(INT32_C(1) << (out_bits - 1));
+  norm_out_max = (INT32_C(1) << (out_bits - 1)) - 1;
+  return recip_scale;
+}
+
+uint32_t softmax_normalize(uint32_t exp) {
+  const int32_t out =
+      gemmlowp::RoundingDivideByPOT(
+          srdhm(recip_scale, static_cast<int32_t>(exp)), recip_shift) +
+      norm_out_min;
+  if (out > norm_out_max) return norm_out_max;
+  if (out < norm_out_min) return norm_out_min;
+  return out;
+}
+
+// (x * multiplier + round) >> shift, as the kernels scale their inputs.
+int32_t sigmoid_scale(int16_t x) {
+  const uint32_t round = sigmoid_shift ? 1u << (sigmoid_shift - 1) : 0;
+  return static_cast<int32_t>(static_cast<uint32_t>(x) *
+                                  static_cast<uint32_t>(sigmoid_multiplier) +
+                              round) >>
+         sigmoid_shift;
+}
+
+// Interpolates sigmoid_table_uint16 and fixes up the sign, as
+// reference_integer_ops::Logistic and Tanh do for int16.
+uint16_t sigmoid_lane(int16_t in) {
+  const int32_t x = sigmoid_scale(in);
+  const uint32_t ax =
+      x < 0 ? -static_cast<uint32_t>(x) : static_cast<uint32_t>(x);
+  const uint32_t uh = sigmoid_tanh ? ax >> 8 : ax >> 9;
+  // Saturated inputs read entry 0, unused.
+  const int index = uh >= 255 ? 0 : uh;
+  const uint32_t ua = tflite::sigmoid_table_uint16[index];
+  const uint32_t ub = tflite::sigmoid_table_uint16[index + 1];
+  uint32_t result;
+  if (sigmoid_tanh) {
+    result = uh >= 255 ? 0xffffu << 8 : (ua << 8) + (ax & 0xff) * (ub - ua);
+    result = x < 0 ? (1u << 23) + (1u << 7) - 1 - result
+                   : result - (1u << 23) + (1u << 7);
+    return result >> 8;
+  }
+  result = uh >= 255 ? 0x7fffu << 10 : (ua << 9) + (ax & 0x1ff) * (ub - ua);
+  result = x < 0 ? (1u << 25) - result + (1u << 9) - 1 : result + (1u << 9);
+  return result >> 10;
+}
+
+}  // anonymous namespace
+
+uint32_t software_cfu(int funct3, int funct7, uint32_t rs1, uint32_t rs2) {
+  (void)funct3;
+  switch (funct7) {
+    case 0:
+      return combined_exponential_reciprocal_approx(rs1);
+    case 2:
+      return softmax_load_sum(rs1, rs2);
+    case 3:
+      return softmax_normalize(rs1);
+    case 4:
+      sigmoid_multiplier = rs1;
+      sigmoid_shift = rs2 & 31;
+      sigmoid_tanh = (rs2 >> 5) & 1;
+      return 0;
+    case 5:
+      return static_cast<uint32_t>(sigmoid_lane(rs1 >> 16)) << 16 |
+             sigmoid_lane(rs1 & 0xffff);
+    default:
+      return exp_on_negative_values(rs1);
+  }
+}
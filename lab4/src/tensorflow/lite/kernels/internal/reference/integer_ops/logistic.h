@@ -16,54 +16,142 @@ limitations under the License.
 #define TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_LOGISTIC_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 
 #include "tensorflow/lite/kernels/internal/common.h"
 
-#include "perf.h"
+#include "cfu.h"
+#include "perf_scope.h"
 
 namespace tflite {
 namespace reference_integer_ops {
 
-inline void Logistic(int32_t input_zero_point, int32_t input_range_radius,
-                     int32_t input_multiplier, int32_t input_left_shift,
-                     int32_t input_size, const int8_t* input_data,
-                     int8_t* output_data) {
-  perf_enable_counter(6);
-
-  // Integer bits must be in sync with Prepare() function.
+// Logistic of one int8 input. Integer bits must be in sync with Prepare().
+inline int8_t LogisticInt8(int32_t input_zero_point, int32_t input_range_radius,
+                           int32_t input_multiplier, int32_t input_left_shift,
+                           int8_t input_value) {
   static constexpr int32_t kInputIntegerBits = 4;
   static constexpr int32_t kOutputIntegerBits = 8;
   static constexpr int8_t kMinInt8 = std::numeric_limits<int8_t>::min();
   static constexpr int8_t kMaxInt8 = std::numeric_limits<int8_t>::max();
   static constexpr int32_t kOutputZeroPoint = -128;
 
+  const int32_t input = static_cast<int32_t>(input_value) - input_zero_point;
+  if (input <= -input_range_radius) {
+    return kMinInt8;
+  } else if (input >= input_range_radius) {
+    return kMaxInt8;
+  }
+
+  const int32_t input_in_q4 =
+      MultiplyByQuantizedMultiplier(input, input_multiplier, input_left_shift);
+  using FixedPoint4 = gemmlowp::FixedPoint<int32_t, kInputIntegerBits>;
+  const int32_t output_in_q0 =
+      gemmlowp::logistic(FixedPoint4::FromRaw(input_in_q4)).raw();
+
+  // Rescale and downcast.
+  using gemmlowp::RoundingDivideByPOT;
+  int32_t output_in_q23 =
+      RoundingDivideByPOT(output_in_q0, 31 - kOutputIntegerBits);
+  output_in_q23 = std::min(std::max(output_in_q23 + kOutputZeroPoint,
+                                    static_cast<int32_t>(kMinInt8)),
+                           static_cast<int32_t>(kMaxInt8));
+  return static_cast<int8_t>(output_in_q23);
+}
+
+inline void Logistic(int32_t input_zero_point, int32_t input_range_radius,
+                     int32_t input_multiplier, int32_t input_left_shift,
+                     int32_t input_size, const int8_t* input_data,
+                     int8_t* output_data) {
+  PERF_SCOPE("logistic");
+
   for (int i = 0; i < input_size; ++i) {
-    const int32_t input =
-        static_cast<int32_t>(input_data[i]) - input_zero_point;
-    if (input <= -input_range_radius) {
-      output_data[i] = kMinInt8;
-    } else if (input >= input_range_radius) {
-      output_data[i] = kMaxInt8;
-    } else {
-      const int32_t input_in_q4 = MultiplyByQuantizedMultiplier(
-          input, input_multiplier, input_left_shift);
-      using FixedPoint4 = gemmlowp::FixedPoint<int32_t, kInputIntegerBits>;
-      const int32_t output_in_q0 =
-          gemmlowp::logistic(FixedPoint4::FromRaw(input_in_q4)).raw();
-
-      // Rescale and downcast.
-      using gemmlowp::RoundingDivideByPOT;
-      int32_t output_in_q23 =
-          RoundingDivideByPOT(output_in_q0, 31 - kOutputIntegerBits);
-      output_in_q23 = std::min(std::max(output_in_q23 + kOutputZeroPoint,
-                                        static_cast<int32_t>(kMinInt8)),
-                               static_cast<int32_t>(kMaxInt8));
-      output_data[i] = static_cast<int8_t>(output_in_q23);
+    output_data[i] =
+        LogisticInt8(input_zero_point, input_range_radius, input_multiplier,
+                     input_left_shift, input_data[i]);
+  }
+}
+
+// Number of entries in an int8 Logistic lookup table.
+constexpr int kLogisticLutInt8Size = 256;
+
+// Fills |lut| so that lut[static_cast<uint8_t>(x)] == Logistic(x) for every
+// int8 x, with the same quantization parameters as Logistic() above.
+inline void PopulateLogisticLutInt8(int32_t input_zero_point,
+                                    int32_t input_range_radius,
+                                    int32_t input_multiplier,
+                                    int32_t input_left_shift, int8_t* lut) {
+  for (int i = std::numeric_limits<int8_t>::min();
+       i <= std::numeric_limits<int8_t>::max(); ++i) {
+    lut[static_cast<uint8_t>(i)] =
+        LogisticInt8(input_zero_point, input_range_radius, input_multiplier,
+                     input_left_shift, static_cast<int8_t>(i));
+  }
+}
+
+// int8 Logistic through a table built by PopulateLogisticLutInt8(). When both
+// buffers are word aligned, four elements are loaded, looked up and stored per
+// iteration. FUSED_SWISH walks its own table with this too, so the perf scope
+// is left to the callers.
+inline void LogisticLut(const int8_t* lut, int32_t input_size,
+                        const int8_t* input_data, int8_t* output_data) {
+  const uint8_t* table = reinterpret_cast<const uint8_t*>(lut);
+  int i = 0;
+  if (((reinterpret_cast<uintptr_t>(input_data) |
+        reinterpret_cast<uintptr_t>(output_data)) &
+       3) == 0) {
+    const uint32_t* input_words = reinterpret_cast<const uint32_t*>(input_data);
+    uint32_t* output_words = reinterpret_cast<uint32_t*>(output_data);
+    for (; i + 4 <= input_size; i += 4) {
+      const uint32_t in = *input_words++;
+      *output_words++ = static_cast<uint32_t>(table[in & 0xff]) |
+                        static_cast<uint32_t>(table[(in >> 8) & 0xff]) << 8 |
+                        static_cast<uint32_t>(table[(in >> 16) & 0xff]) << 16 |
+                        static_cast<uint32_t>(table[in >> 24]) << 24;
     }
   }
-  
-  perf_disable_counter(6);
+  for (; i < input_size; ++i) {
+    output_data[i] = lut[static_cast<uint8_t>(input_data[i])];
+  }
+}
+
+// int16 Logistic, or Tanh if |tanh|, through sigmoid_table_uint16 on the CFU.
+// The CFU scales each input by |input_multiplier| and |input_left_shift|,
+// interpolates between two table entries and fixes up the sign, exactly as
+// the scalar reference loops did, for two elements per instruction.
+inline void SigmoidTableInt16(bool tanh, int32_t input_multiplier,
+                              int32_t input_left_shift, int32_t input_size,
+                              const int16_t* input_data,
+                              int16_t* output_data) {
+  PERF_SCOPE("cfu.sigmoid16");
+  cfu_op1(4, input_multiplier, input_left_shift | (tanh ? 1 << 5 : 0));
+
+  int i = 0;
+  if (((reinterpret_cast<uintptr_t>(input_data) |
+        reinterpret_cast<uintptr_t>(output_data)) &
+       3) == 0) {
+    const uint32_t* input_words = reinterpret_cast<const uint32_t*>(input_data);
+    uint32_t* output_words = reinterpret_cast<uint32_t*>(output_data);
+    for (; i + 2 <= input_size; i += 2) {
+      *output_words++ = cfu_op1(5, *input_words++, 0);
+    }
+  }
+  for (; i + 2 <= input_size; i += 2) {
+    const uint32_t result =
+        cfu_op1(5,
+                static_cast<uint16_t>(input_data[i]) |
+                    static_cast<uint32_t>(static_cast<uint16_t>(
+                        input_data[i + 1]))
+                        << 16,
+                0);
+    output_data[i] = static_cast<int16_t>(result & 0xffff);
+    output_data[i + 1] = static_cast<int16_t>(result >> 16);
+  }
+  if (i < input_size) {
+    output_data[i] = static_cast<int16_t>(
+        cfu_op1(5, static_cast<uint16_t>(input_data[i]), 0) & 0xffff);
+  }
 }
 
 inline void Logistic(int32_t input_multiplier, int32_t input_left_shift,
@@ -83,42 +171,8 @@ inline void Logistic(int32_t input_multiplier, int32_t input_left_shift,
     input_left_shift = 0;
   }
 
-  int32_t round = (input_left_shift > 0) ? 1 << (input_left_shift - 1) : 0;
-
-  for (int i = 0; i < input_size; ++i, ptr_input_data++, ptr_output_data++) {
-    int32_t input_data =
-        ((*ptr_input_data) * input_multiplier + round) >> input_left_shift;
-
-    // We do interpolation on unsigned values.
-    uint32_t abs_input_data = abs(input_data);
-
-    // We divide by 2 power of 9, because
-    // we need to divide by 2 in power of 7 for
-    // the input conversion + 1/4 from the scale above.
-
-    // Define uh as uint32_t type not to make this function overflow.
-    uint32_t uh = abs_input_data >> 9;
-    uint32_t result;
-
-    if (uh >= 255) {
-      // Saturate to maximum.
-      result = 0x7FFF << 10;
-    } else {
-      uint32_t ua = sigmoid_table_uint16[uh];
-      uint32_t ub = sigmoid_table_uint16[uh + 1];
-      uint32_t ut = abs_input_data & 0x1ff;
-      // Interpolation is done using the fractional bit.
-      result = (ua << 9) + ut * (ub - ua);
-    }
-
-    result = (input_data >= 0) ? (result + (1 << 9))
-                               : ((1 << (16 + 9)) - result + (1 << 9) - 1);
-
-    // Back to 16-bit.
-    result >>= 10;
-
-    *ptr_output_data = result;
-  }
+  SigmoidTableInt16(/*tanh=*/false, input_multiplier, input_left_shift,
+                    input_size, ptr_input_data, ptr_output_data);
 }
 
 }  // namespace reference_integer_ops
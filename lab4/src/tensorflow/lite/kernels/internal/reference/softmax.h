@@ -25,7 +25,8 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 
-#include "perf.h"
+#include "cfu.h"
+#include "perf_scope.h"
 
 namespace tflite {
 namespace reference_ops {
@@ -64,24 +65,147 @@ inline void Softmax(const SoftmaxParams& params,
   }
 }
 
+// Number of entries in SoftmaxParams::exp_lut_int8: one per possible
+// max_in_row - input for 8-bit input.
+constexpr int kSoftmaxExpLutInt8Size = 256;
+
+// The representation chosen for the input to the exp() function is Q5.26.
+// We need to leave extra space since values that we skip might be as large as
+// -32 before multiplying by input_beta_multiplier, and therefore as large as
+// -16 afterwards.  Note that exp(-8) is definitely not insignificant to
+// accumulation, but exp(-16) definitely is.
+constexpr int kSoftmaxScaledDiffIntegerBits = 5;
+constexpr int kSoftmaxAccumulationIntegerBits = 12;
+
+// Fills the exp_lut_int8 table used by the quantized Softmax below. Entry i
+// holds exp_on_negative_values() of input_diff = -i in Q0.31, or zero if
+// -i < diff_min, so that skipped values add nothing to the sum and saturate to
+// the output minimum exactly as the per-element branch does.
+inline void PopulateSoftmaxExpLutInt8(const SoftmaxParams& params,
+                                      int32_t* exp_lut) {
+  using FixedPointScaledDiff =
+      gemmlowp::FixedPoint<int32_t, kSoftmaxScaledDiffIntegerBits>;
+
+  for (int i = 0; i < kSoftmaxExpLutInt8Size; ++i) {
+    const int32_t input_diff = -i;
+    if (input_diff >= params.diff_min) {
+      const int32_t input_diff_rescaled =
+          MultiplyByQuantizedMultiplierGreaterThanOne(
+              input_diff, params.input_multiplier, params.input_left_shift);
+      exp_lut[i] = exp_on_negative_values(
+                       FixedPointScaledDiff::FromRaw(input_diff_rescaled))
+                       .raw();
+    } else {
+      exp_lut[i] = 0;
+    }
+  }
+}
+
+// Quantized softmax through the exp table built by PopulateSoftmaxExpLutInt8().
+//
+// The sum of exps is a plain integer sum of Rescale<12>(exp_lut[max - x]) and
+// so does not depend on the order of its terms. That lets one pass over the
+// row track the max and a histogram of input values at the same time; the sum
+// is then formed from the occupied bins once the final max is known, and a
+// second pass normalizes. Bit-identical to the three-pass form.
+//
+// For signed outputs the reciprocal of the sum and the per-element rescale
+// and saturation run on the CFU (funct7 = 2 loads the sum, funct7 = 3 maps
+// one exp to the output value).
+template <typename InputT, typename OutputT>
+inline void SoftmaxWithExpLut(const SoftmaxParams& params,
+                              const RuntimeShape& input_shape,
+                              const InputT* input_data,
+                              const RuntimeShape& output_shape,
+                              OutputT* output_data) {
+  static_assert(sizeof(InputT) == 1, "exp table covers 8-bit input only");
+  static const int kAccumulationIntegerBits = kSoftmaxAccumulationIntegerBits;
+  using FixedPoint0 = gemmlowp::FixedPoint<int32_t, 0>;
+  constexpr int kInputMin = std::numeric_limits<InputT>::min();
+  constexpr int32_t kOutputMin = std::numeric_limits<OutputT>::min();
+  constexpr int32_t kOutputMax = std::numeric_limits<OutputT>::max();
+
+  const int32_t* exp_lut = params.exp_lut_int8;
+  const int trailing_dim = input_shape.DimensionsCount() - 1;
+  const int outer_size =
+      MatchingFlatSizeSkipDim(input_shape, trailing_dim, output_shape);
+  const int depth =
+      MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
+
+  // Every bin is cleared again as it is consumed below.
+  int32_t histogram[kSoftmaxExpLutInt8Size] = {};
+
+  for (int i = 0; i < outer_size; ++i) {
+    const InputT* input_row = input_data + i * depth;
+    OutputT* output_row = output_data + i * depth;
+
+    int max_in_row = std::numeric_limits<InputT>::min();
+    int min_in_row = std::numeric_limits<InputT>::max();
+    for (int c = 0; c < depth; ++c) {
+      const int input = input_row[c];
+      max_in_row = std::max(max_in_row, input);
+      min_in_row = std::min(min_in_row, input);
+      ++histogram[input - kInputMin];
+    }
+
+    // uint32_t so that the sum wraps exactly like repeated FixedPoint adds.
+    uint32_t sum_of_exps_raw = 0;
+    for (int v = min_in_row; v <= max_in_row; ++v) {
+      int32_t& count = histogram[v - kInputMin];
+      const int32_t exp_in_accum =
+          gemmlowp::Rescale<kAccumulationIntegerBits>(
+              FixedPoint0::FromRaw(exp_lut[max_in_row - v]))
+              .raw();
+      sum_of_exps_raw +=
+          static_cast<uint32_t>(count) * static_cast<uint32_t>(exp_in_accum);
+      count = 0;
+    }
+
+    if (std::numeric_limits<OutputT>::is_signed) {
+      cfu_op1(2, sum_of_exps_raw, sizeof(OutputT) * 8);
+      for (int c = 0; c < depth; ++c) {
+        output_row[c] = static_cast<OutputT>(
+            cfu_op1(3, exp_lut[max_in_row - input_row[c]], 0));
+      }
+      continue;
+    }
+
+    int num_bits_over_unit;
+    const FixedPoint0 shifted_scale = FixedPoint0::FromRaw(
+        GetReciprocal(static_cast<int32_t>(sum_of_exps_raw),
+                      kAccumulationIntegerBits, &num_bits_over_unit));
+    const int output_shift = num_bits_over_unit + 31 - (sizeof(OutputT) * 8);
+
+    for (int c = 0; c < depth; ++c) {
+      const FixedPoint0 exp_in_0 =
+          FixedPoint0::FromRaw(exp_lut[max_in_row - input_row[c]]);
+      const int32_t unsat_output = gemmlowp::RoundingDivideByPOT(
+          (shifted_scale * exp_in_0).raw(), output_shift);
+      output_row[c] = static_cast<OutputT>(
+          std::max(std::min(unsat_output + kOutputMin, kOutputMax), kOutputMin));
+    }
+  }
+}
+
 // Quantized softmax with int8_t/uint8_t input and int8_t/uint8_t/int16_t
 // output.
 template <typename InputT, typename OutputT>
 inline void Softmax(const SoftmaxParams& params,
                     const RuntimeShape& input_shape, const InputT* input_data,
                     const RuntimeShape& output_shape, OutputT* output_data) {
-  perf_enable_counter(5);
+  PERF_SCOPE("softmax");
+
+  if (params.exp_lut_int8 != nullptr) {
+    SoftmaxWithExpLut(params, input_shape, input_data, output_shape,
+                      output_data);
+    return;
+  }
 
   const int32_t input_beta_multiplier = params.input_multiplier;
   const int32_t input_beta_left_shift = params.input_left_shift;
   const int diff_min = params.diff_min;
-  // The representation chosen for the input to the exp() function is Q5.26.
-  // We need to leave extra space since values that we skip might be as large as
-  // -32 before multiplying by input_beta_multiplier, and therefore as large as
-  // -16 afterwards.  Note that exp(-8) is definitely not insignificant to
-  // accumulation, but exp(-16) definitely is.
-  static const int kScaledDiffIntegerBits = 5;
-  static const int kAccumulationIntegerBits = 12;
+  static const int kScaledDiffIntegerBits = kSoftmaxScaledDiffIntegerBits;
+  static const int kAccumulationIntegerBits = kSoftmaxAccumulationIntegerBits;
   using FixedPointScaledDiff =
       gemmlowp::FixedPoint<int32_t, kScaledDiffIntegerBits>;
   using FixedPointAccum =
@@ -95,15 +219,17 @@ inline void Softmax(const SoftmaxParams& params,
       MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
 
   for (int i = 0; i < outer_size; ++i) {
+    const InputT* input_row = input_data + i * depth;
+    OutputT* output_row = output_data + i * depth;
+
     InputT max_in_row = std::numeric_limits<InputT>::min();
     for (int c = 0; c < depth; ++c) {
-      max_in_row = std::max(max_in_row, input_data[i * depth + c]);
+      max_in_row = std::max(max_in_row, input_row[c]);
     }
 
     FixedPointAccum sum_of_exps = FixedPointAccum::Zero();
     for (int c = 0; c < depth; ++c) {
-      int32_t input_diff =
-          static_cast<int32_t>(input_data[i * depth + c]) - max_in_row;
+      int32_t input_diff = static_cast<int32_t>(input_row[c]) - max_in_row;
       if (input_diff >= diff_min) {
         const int32_t input_diff_rescaled =
             MultiplyByQuantizedMultiplierGreaterThanOne(
@@ -118,10 +244,10 @@ inline void Softmax(const SoftmaxParams& params,
     int num_bits_over_unit;
     FixedPoint0 shifted_scale = FixedPoint0::FromRaw(GetReciprocal(
         sum_of_exps.raw(), kAccumulationIntegerBits, &num_bits_over_unit));
+    const int output_shift = num_bits_over_unit + 31 - (sizeof(OutputT) * 8);
 
     for (int c = 0; c < depth; ++c) {
-      int32_t input_diff =
-          static_cast<int32_t>(input_data[i * depth + c]) - max_in_row;
+      int32_t input_diff = static_cast<int32_t>(input_row[c]) - max_in_row;
       if (input_diff >= diff_min) {
         const int32_t input_diff_rescaled =
             MultiplyByQuantizedMultiplierGreaterThanOne(
@@ -131,24 +257,21 @@ inline void Softmax(const SoftmaxParams& params,
 
         FixedPoint0 exp_in_0 = exp_on_negative_values(scaled_diff_f8);
         int32_t unsat_output = gemmlowp::RoundingDivideByPOT(
-            (shifted_scale * exp_in_0).raw(),
-            num_bits_over_unit + 31 - (sizeof(OutputT) * 8));
+            (shifted_scale * exp_in_0).raw(), output_shift);
 
         const int32_t shifted_output =
             unsat_output +
             static_cast<int32_t>(std::numeric_limits<OutputT>::min());
 
-        output_data[i * depth + c] = static_cast<OutputT>(std::max(
+        output_row[c] = static_cast<OutputT>(std::max(
             std::min(shifted_output,
                      static_cast<int32_t>(std::numeric_limits<OutputT>::max())),
             static_cast<int32_t>(std::numeric_limits<OutputT>::min())));
       } else {
-        output_data[i * depth + c] = std::numeric_limits<OutputT>::min();
+        output_row[c] = std::numeric_limits<OutputT>::min();
       }
     }
   }
-
-  perf_disable_counter(5);
 }
 
 // Computes exp(input - max_input)
@@ -0,0 +1,386 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_TRANSPOSE_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_TRANSPOSE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+
+namespace reference_ops {
+
+namespace transpose_internal {
+
+// Recursively explores all the dimensions of the output tensor and writes the
+// corresponding input tensor data.
+//
+// - depth: the current depth of the recursion.
+// - dims: tensor dimension count, also `perm` size.
+// - perm: permutation array.
+// - input_data: Running input data pointer. If depth == num_dims-1, this points
+//               to the first element of the last dimension to traverse.
+// - input_stride: Reverse partial product of input shapes.
+// - output_data: Running output data pointer. If depth == num_dims-1, this
+//                points to the first element of the last dimension to traverse.
+// - output_stride: Reverse partial product of output shapes.
+// - output_shape: Shape of the output tensor.
+//
+// ## Algorithm explanation
+//
+// Assume a 3D tensor T with a shape of [I, J, K] stored in row major order.
+// T[i, j, k] is at position `i*J*K + j*K + k` in the tensor buffer.
+//
+// If we want to go through the whole tensor iteratively, we can use loops.
+//
+// ```
+// for(i = 0; i < I; ++i) {
+//   for(j = 0; j < J; ++j) {
+//     for(k = 0; k < K; ++k) {
+//        T.data[i*J*K + j*K + k] = ...
+//     }
+//   }
+// }
+// ```
+//
+// We can also compute the offset as we go through the loops.
+//
+// ```
+// stride_i = K * J;
+// stride_j = K;
+// stride_k = 1;
+// for(i = 0; i < I; ++i) {
+//   offset_i = i * stride_i;
+//   offset_j = 0;
+//   for(j = 0; j < J; ++j) {
+//     offset_j += stride_j;
+//     offset_k = 0;
+//     for(k = 0; k < K; ++k) {
+//        offset_k += stride_k;
+//        T.data[offset_i + offset_j + offset_k] = ...
+//     }
+//   }
+// }
+// ```
+//
+// This nicely extends to a recursive version which is the base of this
+// algorithm and supports any number of dimensions.
+//
+// ```
+// shape = [I, J, K]
+// strides = [K*J, K, 1]
+// void recurse(T* data, shape, strides, depth = 0) {
+//   if(depth == shape.size) {
+//     *data = ...
+//   } else {
+//     for(a = 0; a < shape[depth]; ++a) {
+//       recurse(data, shape, strides, depth+1);
+//       data += strides[depth];
+//     }
+//   }
+// }
+// ```
+template <typename T>
+void TransposeImpl(const int depth, const int dims, const int32_t* perm,
+                   const T* input_data, const int* input_stride, T* output_data,
+                   const int* output_stride, const int32_t* output_shape) {
+  const int dimension_size = output_shape[depth];
+  if (depth == dims - 1) {
+    const int loop_stride = input_stride[perm[depth]];
+    for (int i = 0; i < dimension_size; ++i) {
+      output_data[i] = *input_data;
+      input_data += loop_stride;
+    }
+  } else {
+    for (int i = 0; i < dimension_size; ++i) {
+      TransposeImpl(depth + 1, dims, perm, input_data, input_stride,
+                    output_data, output_stride, output_shape);
+
+      input_data += input_stride[perm[depth]];
+      output_data += output_stride[depth];
+    }
+  }
+}
+
+// Compile-time switch to get the storage type of the transposition.
+template <int Size>
+struct TransposeStorageType;
+
+template <>
+struct TransposeStorageType<1> {
+  using type = int8_t;
+};
+
+template <>
+struct TransposeStorageType<2> {
+  using type = int16_t;
+};
+
+template <>
+struct TransposeStorageType<4> {
+  using type = int32_t;
+};
+
+template <>
+struct TransposeStorageType<8> {
+  using type = int64_t;
+};
+
+// Sets up the stride arrays for the recursive transpose algorithm.
+//
+// Implementation notes:
+//
+// This is a reverse partial product. We could use standard algorithms to
+// implement this but the result is not a readable and is tricky to get right
+// because the first element must be set to 1, which leads to offset
+// shenanigans:
+//
+// ```
+//   stride[dims - 1] = 1;
+//   std::partial_sum(std::make_reverse_iterator(shape + dims),
+//                    std::make_reverse_iterator(shape + 1),
+//                    stride.rend() - input_rank + 1, std::multiplies());
+// ```
+//
+// Note that Abseil isn't used in kernels implementation. That would make the
+// above solution more readable.
+inline void SetupTransposeStrides(
+    std::array<int, kTransposeMaxDimensions>& stride, const int32_t* shape,
+    const int dims) {
+  stride[dims - 1] = 1;
+  for (int i = dims - 2; i >= 0; --i) {
+    stride[i] = stride[i + 1] * shape[i + 1];
+  }
+}
+
+// Rewrites a transpose into the fewest dimensions that describe it: size-1
+// dimensions are dropped and input dimensions that stay next to each other in
+// the output are fused. NHWC <-> NCHW becomes a batched 2-D transpose, a swap
+// of the last two dimensions becomes a 2-D or batched 2-D transpose, and any
+// permutation that keeps the innermost dimension in place (MobileViT's patch
+// unfold and fold) ends in a contiguous run. Returns the new rank.
+inline int CanonicalizeTranspose(const int32_t* shape, const int32_t* perm,
+                                 const int dims, int32_t* canonical_shape,
+                                 int32_t* canonical_perm) {
+  // Drop size-1 dimensions.
+  int32_t kept_index[kTransposeMaxDimensions];
+  int kept = 0;
+  for (int i = 0; i < dims; ++i) {
+    kept_index[i] = shape[i] == 1 ? -1 : kept++;
+  }
+  int32_t squeezed_perm[kTransposeMaxDimensions];
+  int32_t squeezed_shape[kTransposeMaxDimensions];
+  int squeezed = 0;
+  for (int i = 0; i < dims; ++i) {
+    if (kept_index[perm[i]] >= 0) {
+      squeezed_perm[squeezed++] = kept_index[perm[i]];
+    }
+  }
+  for (int i = 0; i < dims; ++i) {
+    if (kept_index[i] >= 0) {
+      squeezed_shape[kept_index[i]] = shape[i];
+    }
+  }
+
+  // Fuse runs of consecutive input dimensions in output order. Each group is
+  // identified by its first input dimension.
+  int32_t group_first[kTransposeMaxDimensions];
+  int32_t group_size[kTransposeMaxDimensions];
+  int groups = 0;
+  for (int i = 0; i < squeezed; ++i) {
+    if (i > 0 && squeezed_perm[i] == squeezed_perm[i - 1] + 1) {
+      group_size[groups - 1] *= squeezed_shape[squeezed_perm[i]];
+    } else {
+      group_first[groups] = squeezed_perm[i];
+      group_size[groups] = squeezed_shape[squeezed_perm[i]];
+      ++groups;
+    }
+  }
+
+  // Groups keep the relative order of their first input dimension.
+  for (int g = 0; g < groups; ++g) {
+    int rank = 0;
+    for (int h = 0; h < groups; ++h) {
+      rank += group_first[h] < group_first[g];
+    }
+    canonical_perm[g] = rank;
+    canonical_shape[rank] = group_size[g];
+  }
+  return groups;
+}
+
+// Copies output dimensions [depth, dims - 1) element by element and the last
+// one, which is also the last input dimension, as one contiguous run.
+template <typename T>
+void TransposeRuns(const int depth, const int dims, const int32_t* perm,
+                   const T* input_data, const int* input_stride,
+                   T* output_data, const int* output_stride,
+                   const int32_t* output_shape) {
+  if (depth == dims - 1) {
+    std::memcpy(output_data, input_data, output_shape[depth] * sizeof(T));
+    return;
+  }
+  const int dimension_size = output_shape[depth];
+  for (int i = 0; i < dimension_size; ++i) {
+    TransposeRuns(depth + 1, dims, perm, input_data, input_stride, output_data,
+                  output_stride, output_shape);
+    input_data += input_stride[perm[depth]];
+    output_data += output_stride[depth];
+  }
+}
+
+// Side of the square blocks the 2-D transpose works through, in elements.
+constexpr int kTransposeBlock = 32;
+
+// Transposes one kTransposeBlock block of a 2-D int8 matrix four rows and four
+// columns at a time: four words are loaded, their bytes swapped in registers
+// and four words stored. Rows, columns and block bounds are multiples of 4.
+inline void Transpose2DBlockInt8Words(const int8_t* input, int8_t* output,
+                                      int rows, int cols, int row_begin,
+                                      int row_end, int col_begin,
+                                      int col_end) {
+  for (int r = row_begin; r < row_end; r += 4) {
+    for (int c = col_begin; c < col_end; c += 4) {
+      const int8_t* in = input + r * cols + c;
+      const uint32_t r0 = *reinterpret_cast<const uint32_t*>(in);
+      const uint32_t r1 = *reinterpret_cast<const uint32_t*>(in + cols);
+      const uint32_t r2 = *reinterpret_cast<const uint32_t*>(in + 2 * cols);
+      const uint32_t r3 = *reinterpret_cast<const uint32_t*>(in + 3 * cols);
+      // Little-endian: byte j of each word is column c + j.
+      const uint32_t t0 = (r0 & 0x00ff00ff) | ((r1 & 0x00ff00ff) << 8);
+      const uint32_t t1 = ((r0 >> 8) & 0x00ff00ff) | (r1 & 0xff00ff00);
+      const uint32_t t2 = (r2 & 0x00ff00ff) | ((r3 & 0x00ff00ff) << 8);
+      const uint32_t t3 = ((r2 >> 8) & 0x00ff00ff) | (r3 & 0xff00ff00);
+      int8_t* out = output + c * rows + r;
+      *reinterpret_cast<uint32_t*>(out) = (t0 & 0xffff) | (t2 << 16);
+      *reinterpret_cast<uint32_t*>(out + rows) = (t1 & 0xffff) | (t3 << 16);
+      *reinterpret_cast<uint32_t*>(out + 2 * rows) =
+          (t0 >> 16) | (t2 & 0xffff0000);
+      *reinterpret_cast<uint32_t*>(out + 3 * rows) =
+          (t1 >> 16) | (t3 & 0xffff0000);
+    }
+  }
+}
+
+// output[b][c][r] = input[b][r][c], in kTransposeBlock square blocks.
+template <typename T>
+void TransposeBatched2D(const T* input_data, T* output_data, int batches,
+                        int rows, int cols) {
+  bool int8_words = false;
+  if (sizeof(T) == 1) {
+    int8_words = rows % 4 == 0 && cols % 4 == 0 &&
+                 ((reinterpret_cast<uintptr_t>(input_data) |
+                   reinterpret_cast<uintptr_t>(output_data)) &
+                  3) == 0;
+  }
+  const int matrix_size = rows * cols;
+  for (int b = 0; b < batches; ++b) {
+    const T* input = input_data + b * matrix_size;
+    T* output = output_data + b * matrix_size;
+    for (int row_begin = 0; row_begin < rows; row_begin += kTransposeBlock) {
+      const int row_end = std::min(row_begin + kTransposeBlock, rows);
+      for (int col_begin = 0; col_begin < cols; col_begin += kTransposeBlock) {
+        const int col_end = std::min(col_begin + kTransposeBlock, cols);
+        if (int8_words) {
+          Transpose2DBlockInt8Words(reinterpret_cast<const int8_t*>(input),
+                                    reinterpret_cast<int8_t*>(output), rows,
+                                    cols, row_begin, row_end, col_begin,
+                                    col_end);
+          continue;
+        }
+        for (int r = row_begin; r < row_end; ++r) {
+          for (int c = col_begin; c < col_end; ++c) {
+            output[c * rows + r] = input[r * cols + c];
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace transpose_internal
+
+// Copies a tensor to an other buffer and permutes its dimensions.
+//
+// Note: template parameter N is not used anymore. It is kept for API
+// compatibility with TFLite micro.
+template <typename T, int N = kTransposeMaxDimensions>
+void Transpose(const TransposeParams& params, const RuntimeShape& input_shape,
+               const T* input_data, const RuntimeShape& output_shape,
+               T* output_data) {
+  using transpose_internal::SetupTransposeStrides;
+  using transpose_internal::TransposeImpl;
+  using transpose_internal::TransposeStorageType;
+  // Transpose kernel only does rearranging values not numeric evaluations on
+  // each cell. It's safe to implement per size of scalar type and this trick
+  // keeps the total code size in a reasonable range.
+  using StorageType = typename TransposeStorageType<sizeof(T)>::type;
+  const StorageType* const input_data_storage =
+      reinterpret_cast<const StorageType*>(input_data);
+  StorageType* const output_data_storage =
+      reinterpret_cast<StorageType*>(output_data);
+
+  // Work on the canonical form, which picks the specialized kernels below
+  // and gives the generic one fewer dimensions to walk.
+  int32_t shape[kTransposeMaxDimensions];
+  int32_t perm[kTransposeMaxDimensions];
+  const int dims = transpose_internal::CanonicalizeTranspose(
+      input_shape.DimsData(), &params.perm[0],
+      input_shape.DimensionsCount(), shape, perm);
+
+  // Identity: one copy of the whole tensor.
+  if (dims <= 1) {
+    std::memcpy(output_data_storage, input_data_storage,
+                input_shape.FlatSize() * sizeof(StorageType));
+    return;
+  }
+
+  // Swap of the last two dimensions, with or without a leading batch.
+  if (dims == 2 || (dims == 3 && perm[0] == 0)) {
+    transpose_internal::TransposeBatched2D(
+        input_data_storage, output_data_storage, dims == 3 ? shape[0] : 1,
+        shape[dims - 2], shape[dims - 1]);
+    return;
+  }
+
+  int32_t canonical_output_shape[kTransposeMaxDimensions];
+  for (int i = 0; i < dims; ++i) {
+    canonical_output_shape[i] = shape[perm[i]];
+  }
+  std::array<int, kTransposeMaxDimensions> input_stride, output_stride;
+  SetupTransposeStrides(input_stride, shape, dims);
+  SetupTransposeStrides(output_stride, canonical_output_shape, dims);
+
+  // Innermost dimension stays in place: copy it as contiguous runs.
+  if (perm[dims - 1] == dims - 1) {
+    transpose_internal::TransposeRuns(
+        0, dims, perm, input_data_storage, input_stride.data(),
+        output_data_storage, output_stride.data(), canonical_output_shape);
+    return;
+  }
+
+  TransposeImpl(0, dims, perm, input_data_storage, input_stride.data(),
+                output_data_storage, output_stride.data(),
+                canonical_output_shape);
+}
+
+}  // namespace reference_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_TRANSPOSE_H_
@@ -124,6 +124,9 @@ AllOpsResolver::AllOpsResolver() {
   AddWhile();
   AddZerosLike();
   AddBatchMatMul();
+  AddFusedAttention();
+  AddFusedSwish();
+  AddFusedLayerNorm();
 }
 
 }  // namespace tflite
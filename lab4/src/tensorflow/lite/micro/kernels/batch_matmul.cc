@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/fused_attention.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
@@ -54,9 +55,13 @@ struct QuantizationOpData {
 struct OpData {
   QuantizationOpData* quantization;
 
-  // Transpose tensors and state
+  // Transpose tensors and state. The data of a transpose tensor lives in the
+  // scratch buffer at its *_scratch_index, or -1 if it is persistent (a
+  // constant RHS transposed once in Prepare).
   TfLiteEvalTensor* lhs_transposed_tensor;
   TfLiteEvalTensor* rhs_transposed_tensor;
+  int lhs_scratch_index;
+  int rhs_scratch_index;
   bool rhs_is_transposed;
   bool lhs_is_constant_tensor;
   bool rhs_is_constant_tensor;
@@ -153,8 +158,64 @@ TfLiteStatus ReshapeOutputTensor(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+size_t TransposeDataSize(const TfLiteTensor& tensor) {
+  return static_cast<size_t>(NumElements(&tensor)) *
+         TfLiteTypeGetSize(tensor.type);
+}
+
+// Constant RHS operands transposed in Prepare, shared by every BATCH_MATMUL
+// node that multiplies by the same weight tensor. All Init calls of a graph
+// run before any of its Prepare calls, so BatchMatMulInit clearing the table
+// keeps out entries that point into an earlier interpreter's arena.
+//
+// The converter deduplicates identical buffers, so one buffer can back
+// tensors of different shapes or types. An entry is only shared when the
+// type and the dimensions match as well.
+struct SharedTranspose {
+  const void* source;
+  TfLiteEvalTensor* transposed;
+};
+constexpr int kMaxSharedTransposes = 16;
+SharedTranspose shared_transposes[kMaxSharedTransposes];
+int shared_transpose_count = 0;
+
+// Whether |transposed| is |tensor| with its last two dimensions swapped.
+bool IsTransposeOf(const TfLiteEvalTensor& transposed,
+                   const TfLiteTensor& tensor) {
+  const int rank = NumDimensions(&tensor);
+  if (transposed.type != tensor.type || transposed.dims->size != rank) {
+    return false;
+  }
+  for (int i = 0; i < rank - 2; ++i) {
+    if (transposed.dims->data[i] != tensor.dims->data[i]) return false;
+  }
+  return transposed.dims->data[rank - 2] == tensor.dims->data[rank - 1] &&
+         transposed.dims->data[rank - 1] == tensor.dims->data[rank - 2];
+}
+
+TfLiteEvalTensor* FindSharedTranspose(const TfLiteTensor& source) {
+  for (int i = 0; i < shared_transpose_count; ++i) {
+    if (shared_transposes[i].source == source.data.data &&
+        IsTransposeOf(*shared_transposes[i].transposed, source)) {
+      return shared_transposes[i].transposed;
+    }
+  }
+  return nullptr;
+}
+
+void AddSharedTranspose(const TfLiteTensor& source,
+                        TfLiteEvalTensor* transposed) {
+  if (shared_transpose_count < kMaxSharedTransposes) {
+    shared_transposes[shared_transpose_count++] = {source.data.data,
+                                                   transposed};
+  }
+}
+
+// Allocates a TfLiteEvalTensor with the last two dimensions of |tensor|
+// swapped. Its data buffer is only allocated when |persistent_data| is set;
+// otherwise Eval points it at a scratch buffer.
 TfLiteEvalTensor* AllocInitTransposeTensorFromTfLiteTensor(
-    TfLiteContext* context, const TfLiteTensor& tensor) {
+    TfLiteContext* context, const TfLiteTensor& tensor, bool persistent_data) {
   MicroContext* micro_context = GetMicroContext(context);
   TfLiteEvalTensor* eval_tensor = static_cast<TfLiteEvalTensor*>(
       micro_context->AllocatePersistentBuffer(sizeof(TfLiteEvalTensor)));
@@ -179,58 +240,18 @@ TfLiteEvalTensor* AllocInitTransposeTensorFromTfLiteTensor(
   eval_tensor->dims->data[tensor_rank - 2] = tensor.dims->data[tensor_rank - 1];
   eval_tensor->dims->data[tensor_rank - 1] = tensor.dims->data[tensor_rank - 2];
 
-  const size_t eval_data_size = static_cast<size_t>(NumElements(&tensor)) *
-                                TfLiteTypeGetSize(tensor.type);
-  eval_tensor->data.data =
-      micro_context->AllocatePersistentBuffer(eval_data_size);
-  if (eval_tensor->data.data == nullptr) {
-    return nullptr;
+  eval_tensor->data.data = nullptr;
+  if (persistent_data) {
+    eval_tensor->data.data =
+        micro_context->AllocatePersistentBuffer(TransposeDataSize(tensor));
+    if (eval_tensor->data.data == nullptr) {
+      return nullptr;
+    }
   }
 
   return eval_tensor;
 }
 
-// Initializes tensors to store transposed operands.
-// Allocate storage for hybrid quantization if needed.
-// Allocate normal quantization data if needed.
-TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
-                                   const PrepareOpContext& op_context) {
-  OpData* op_data = op_context.op_data;
-  const TfLiteTensor* lhs = op_context.lhs;
-  const TfLiteTensor* rhs = op_context.rhs;
-  MicroContext* micro_context = GetMicroContext(context);
-
-  op_data->quantization = nullptr;
-  op_data->lhs_transposed_tensor = nullptr;
-  op_data->rhs_transposed_tensor = nullptr;
-
-  if (lhs->type == kTfLiteInt8 || lhs->type == kTfLiteInt16) {
-    op_data->quantization = static_cast<decltype(op_data->quantization)>(
-        micro_context->AllocatePersistentBuffer(
-            sizeof(*op_data->quantization)));
-    TF_LITE_ENSURE(context, op_data->quantization != nullptr);
-  }
-
-  // tensor for Transposed LHS;
-  if (op_context.params->adj_x) {
-    op_data->lhs_transposed_tensor =
-        AllocInitTransposeTensorFromTfLiteTensor(context, *lhs);
-    TF_LITE_ENSURE(context, op_data->lhs_transposed_tensor != nullptr);
-  }
-
-  // We need a buffer for the RHS if we need to transpose the RHS. We
-  // transpose by default, so that the two inputs (LHS and RHS) are in a proper
-  // layout for our fast matrix multiplication routines. If the transpose flag
-  // is set by the caller, the data is already in the desired layout.
-  if (!op_context.params->adj_y) {
-    op_data->rhs_transposed_tensor =
-        AllocInitTransposeTensorFromTfLiteTensor(context, *rhs);
-    TF_LITE_ENSURE(context, op_data->rhs_transposed_tensor != nullptr);
-  }
-
-  return kTfLiteOk;
-}
-
 template <typename Scalar>
 void TransposeRowsColumnsImpl(const TfLiteEvalTensor& tensor_in,
                               TfLiteEvalTensor* tensor_out) {
@@ -271,6 +292,78 @@ TfLiteStatus TransposeRowsColumns(const TfLiteEvalTensor& tensor_in,
   return kTfLiteError;
 }
 
+// Initializes tensors to store transposed operands.
+// Allocate storage for hybrid quantization if needed.
+// Allocate normal quantization data if needed.
+TfLiteStatus InitializeTemporaries(TfLiteContext* context, TfLiteNode* node,
+                                   const PrepareOpContext& op_context) {
+  OpData* op_data = op_context.op_data;
+  const TfLiteTensor* lhs = op_context.lhs;
+  const TfLiteTensor* rhs = op_context.rhs;
+  MicroContext* micro_context = GetMicroContext(context);
+
+  op_data->quantization = nullptr;
+  op_data->lhs_transposed_tensor = nullptr;
+  op_data->rhs_transposed_tensor = nullptr;
+  op_data->lhs_scratch_index = -1;
+  op_data->rhs_scratch_index = -1;
+
+  if (lhs->type == kTfLiteInt8 || lhs->type == kTfLiteInt16) {
+    op_data->quantization = static_cast<decltype(op_data->quantization)>(
+        micro_context->AllocatePersistentBuffer(
+            sizeof(*op_data->quantization)));
+    TF_LITE_ENSURE(context, op_data->quantization != nullptr);
+  }
+
+  // tensor for Transposed LHS; rewritten on every Eval, so its data is
+  // scratch that the memory planner can overlap with other nodes.
+  if (op_context.params->adj_x) {
+    op_data->lhs_transposed_tensor =
+        AllocInitTransposeTensorFromTfLiteTensor(context, *lhs, false);
+    TF_LITE_ENSURE(context, op_data->lhs_transposed_tensor != nullptr);
+    TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                   context, TransposeDataSize(*lhs),
+                                   &op_data->lhs_scratch_index));
+  }
+
+  // We need a buffer for the RHS if we need to transpose the RHS. We
+  // transpose by default, so that the two inputs (LHS and RHS) are in a proper
+  // layout for our fast matrix multiplication routines. If the transpose flag
+  // is set by the caller, the data is already in the desired layout. The int8
+  // kernel reads a row-major RHS directly and never needs the copy.
+  //
+  // A constant RHS is transposed once, here, into the persistent area and
+  // shared with other nodes using the same weights. Anything else is
+  // transposed into scratch on every Eval.
+  if (!op_context.params->adj_y && rhs->type != kTfLiteInt8) {
+    if (op_data->rhs_is_constant_tensor) {
+      op_data->rhs_transposed_tensor = FindSharedTranspose(*rhs);
+      if (op_data->rhs_transposed_tensor == nullptr) {
+        op_data->rhs_transposed_tensor =
+            AllocInitTransposeTensorFromTfLiteTensor(context, *rhs, true);
+        TF_LITE_ENSURE(context, op_data->rhs_transposed_tensor != nullptr);
+        TfLiteEvalTensor rhs_eval;
+        rhs_eval.data.data = rhs->data.data;
+        rhs_eval.dims = rhs->dims;
+        rhs_eval.type = rhs->type;
+        TF_LITE_ENSURE_OK(context, TransposeRowsColumns(
+                                       rhs_eval, op_data->rhs_transposed_tensor));
+        AddSharedTranspose(*rhs, op_data->rhs_transposed_tensor);
+      }
+      op_data->rhs_is_transposed = true;
+    } else {
+      op_data->rhs_transposed_tensor =
+          AllocInitTransposeTensorFromTfLiteTensor(context, *rhs, false);
+      TF_LITE_ENSURE(context, op_data->rhs_transposed_tensor != nullptr);
+      TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                     context, TransposeDataSize(*rhs),
+                                     &op_data->rhs_scratch_index));
+    }
+  }
+
+  return kTfLiteOk;
+}
+
 RuntimeShape SwapRowColumnDims(const RuntimeShape& shape) {
   RuntimeShape swapped_shape(shape);
   const int32_t dims = shape.DimensionsCount();
@@ -285,6 +378,7 @@ void* BatchMatMulInit(TfLiteContext* context, const char* buffer,
   // Instead, we allocate a new object to carry information from Prepare() to
   // Eval().
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  shared_transpose_count = 0;
   MicroContext* micro_context = GetMicroContext(context);
   return micro_context->AllocatePersistentBuffer(sizeof(OpData));
 }
@@ -321,14 +415,14 @@ TfLiteStatus BatchMatMulPrepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, rhs_rank >= 2);
   TF_LITE_ENSURE(context, rhs_rank <= 5);
 
-  TF_LITE_ENSURE_OK(context, InitializeTemporaries(context, node, op_context));
-
   OpData* op_data = op_context.op_data;
   // If the RHS is constant, we only transpose once.
   op_data->rhs_is_transposed = false;
   op_data->lhs_is_constant_tensor = IsConstantTensor(lhs_data);
   op_data->rhs_is_constant_tensor = IsConstantTensor(rhs_data);
 
+  TF_LITE_ENSURE_OK(context, InitializeTemporaries(context, node, op_context));
+
   // Note that quantized inference requires that all tensors have their
   // parameters set. This is usually done during quantized training.
   if (lhs_data->type == kTfLiteInt8 || lhs_data->type == kTfLiteInt16) {
@@ -390,7 +484,47 @@ TfLiteStatus BatchMatMulPrepare(TfLiteContext* context, TfLiteNode* node) {
   TfLiteStatus status =
       ReshapeOutputTensor(context, node, extended_lhs_shape, extended_rhs_shape,
                           adj_x, adj_y, output_rank, output);
-  return status;
+  if (status != kTfLiteOk || lhs_data->type != kTfLiteInt8) {
+    return status;
+  }
+  return FuseAttention(context, node);
+}
+
+void FillQuantizedParams(const OpData& data,
+                         FullyConnectedParams* op_params) {
+  op_params->input_offset = -data.quantization->lhs_zero_point;
+  op_params->weights_offset =
+      -data.quantization->rhs_zero_point;  // filter offset
+  op_params->output_offset = data.quantization->output_zero_point;
+  op_params->output_multiplier = data.quantization->output_multiplier;
+  op_params->output_shift = data.quantization->output_shift;
+  op_params->quantized_activation_min =
+      data.quantization->output_activation_min;
+  op_params->quantized_activation_max =
+      data.quantization->output_activation_max;
+  op_params->lhs_cacheable = data.lhs_is_constant_tensor;
+  op_params->rhs_cacheable = data.rhs_is_constant_tensor;
+}
+
+// int8 with the RHS in its original <..., B, C> layout. Operands are passed in
+// their natural order and the output is produced row-major.
+TfLiteStatus EvalInt8RowMajorRhs(TfLiteContext* context, const OpData& data,
+                                 const RuntimeShape& lhs_shape,
+                                 const TfLiteEvalTensor& lhs,
+                                 const RuntimeShape& rhs_shape,
+                                 const TfLiteEvalTensor& rhs,
+                                 const RuntimeShape& output_shape,
+                                 TfLiteEvalTensor* output) {
+  TF_LITE_ENSURE(context, data.quantization != nullptr);
+  FullyConnectedParams op_params;
+  FillQuantizedParams(data, &op_params);
+
+  reference_ops::BatchMatMulRowMajorRhs<int8_t, int32_t>(
+      op_params, lhs_shape, tflite::micro::GetTensorData<int8_t>(&lhs),
+      rhs_shape, tflite::micro::GetTensorData<int8_t>(&rhs), output_shape,
+      tflite::micro::GetTensorData<int8_t>(output));
+
+  return kTfLiteOk;
 }
 
 TfLiteStatus EvalInt8(TfLiteContext* context, const OpData& data,
@@ -403,16 +537,7 @@ TfLiteStatus EvalInt8(TfLiteContext* context, const OpData& data,
   TF_LITE_ENSURE(context, data.quantization != nullptr);
   // Reuse params struct from FullyConnected Op.
   FullyConnectedParams op_params;
-  op_params.input_offset = -data.quantization->lhs_zero_point;
-  op_params.weights_offset =
-      -data.quantization->rhs_zero_point;  // filter offset
-  op_params.output_offset = data.quantization->output_zero_point;
-  op_params.output_multiplier = data.quantization->output_multiplier;
-  op_params.output_shift = data.quantization->output_shift;
-  op_params.quantized_activation_min = data.quantization->output_activation_min;
-  op_params.quantized_activation_max = data.quantization->output_activation_max;
-  op_params.lhs_cacheable = data.lhs_is_constant_tensor;
-  op_params.rhs_cacheable = data.rhs_is_constant_tensor;
+  FillQuantizedParams(data, &op_params);
 
   // Note we pass RHS args first, LHS args second. See note for Eval.
   reference_ops::BatchMatMul<int8_t, int32_t>(
@@ -433,16 +558,7 @@ TfLiteStatus EvalInt16(TfLiteContext* context, const OpData& data,
   TF_LITE_ENSURE(context, data.quantization != nullptr);
   // Reuse params struct from FullyConnected Op.
   FullyConnectedParams op_params;
-  op_params.input_offset = -data.quantization->lhs_zero_point;
-  op_params.weights_offset =
-      -data.quantization->rhs_zero_point;  // filter offset
-  op_params.output_offset = data.quantization->output_zero_point;
-  op_params.output_multiplier = data.quantization->output_multiplier;
-  op_params.output_shift = data.quantization->output_shift;
-  op_params.quantized_activation_min = data.quantization->output_activation_min;
-  op_params.quantized_activation_max = data.quantization->output_activation_max;
-  op_params.lhs_cacheable = data.lhs_is_constant_tensor;
-  op_params.rhs_cacheable = data.rhs_is_constant_tensor;
+  FillQuantizedParams(data, &op_params);
 
   // Note we pass RHS args first, LHS args second. See note for Eval.
   reference_ops::BatchMatMul<int16_t, int64_t>(
@@ -501,23 +617,36 @@ TfLiteStatus BatchMatMulEval(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
-  TfLiteEvalTensor* rhs_tensor = adj_y ? const_cast<TfLiteEvalTensor*>(rhs)
-                                       : op_data->rhs_transposed_tensor;
   TfLiteEvalTensor* lhs_tensor = adj_x ? op_data->lhs_transposed_tensor
                                        : const_cast<TfLiteEvalTensor*>(lhs);
-  TF_LITE_ENSURE(context, rhs_tensor != nullptr);
   TF_LITE_ENSURE(context, lhs_tensor != nullptr);
+  if (adj_x) {
+    lhs_tensor->data.data =
+        context->GetScratchBuffer(context, op_data->lhs_scratch_index);
+    TransposeRowsColumns(*lhs, lhs_tensor);
+  }
+
+  if (lhs->type == kTfLiteInt8 && !adj_y) {
+    const RuntimeShape lhs_shape =
+        adj_x ? SwapRowColumnDims(orig_lhs_shape) : orig_lhs_shape;
+    return EvalInt8RowMajorRhs(context, *op_data, lhs_shape, *lhs_tensor,
+                               orig_rhs_shape, *rhs,
+                               tflite::micro::GetTensorShape(output), output);
+  }
+
+  TfLiteEvalTensor* rhs_tensor = adj_y ? const_cast<TfLiteEvalTensor*>(rhs)
+                                       : op_data->rhs_transposed_tensor;
+  TF_LITE_ENSURE(context, rhs_tensor != nullptr);
   if (!adj_y) {
     // TODO(b/154760341): Constant tensors should already be transposed, but
     // we transpose once if necessary for now.
     if (!(op_data->rhs_is_constant_tensor && op_data->rhs_is_transposed)) {
+      rhs_tensor->data.data =
+          context->GetScratchBuffer(context, op_data->rhs_scratch_index);
       TransposeRowsColumns(*rhs, rhs_tensor);
       op_data->rhs_is_transposed = true;
     }
   }
-  if (adj_x) {
-    TransposeRowsColumns(*lhs, lhs_tensor);
-  }
   RuntimeShape rhs_shape =
       adj_y ? orig_rhs_shape : SwapRowColumnDims(orig_rhs_shape);
   RuntimeShape lhs_shape =
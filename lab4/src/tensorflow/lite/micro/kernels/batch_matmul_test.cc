@@ -0,0 +1,146 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks BatchMatMulRowMajorRhs, which reads the RHS in place, against the
+// generic reference, which wants the RHS transposed, on random int8 data.
+
+#include <stdint.h>
+
+#include "tensorflow/lite/kernels/internal/reference/batch_matmul.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kMaxElements = 2048;
+
+int8_t lhs_data[kMaxElements];
+int8_t rhs_data[kMaxElements];
+int8_t rhs_transposed[kMaxElements];
+int8_t expected[kMaxElements];
+int8_t actual[kMaxElements];
+
+uint32_t random_state;
+
+int8_t RandomInt8() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return static_cast<int8_t>(random_state >> 24);
+}
+
+// |lhs_dims| is <..., A, B> and |rhs_dims| <..., B, C>, both 5-D, with size-1
+// batch dimensions broadcast.
+void TestRowMajorRhs(const int* lhs_dims, const int* rhs_dims,
+                     int32_t lhs_zero_point, int32_t rhs_zero_point,
+                     uint32_t seed) {
+  const RuntimeShape lhs_shape(5, lhs_dims);
+  const RuntimeShape rhs_shape(5, rhs_dims);
+  int out_dims[5];
+  for (int i = 0; i < 3; ++i) {
+    out_dims[i] = reference_ops::batch_matmul::broadcast_dim(lhs_dims[i],
+                                                             rhs_dims[i]);
+  }
+  out_dims[3] = lhs_dims[3];
+  out_dims[4] = rhs_dims[4];
+  const RuntimeShape out_shape(5, out_dims);
+  TF_LITE_MICRO_EXPECT_LE(lhs_shape.FlatSize(), kMaxElements);
+  TF_LITE_MICRO_EXPECT_LE(rhs_shape.FlatSize(), kMaxElements);
+  TF_LITE_MICRO_EXPECT_LE(out_shape.FlatSize(), kMaxElements);
+
+  random_state = seed;
+  for (int i = 0; i < lhs_shape.FlatSize(); ++i) lhs_data[i] = RandomInt8();
+  for (int i = 0; i < rhs_shape.FlatSize(); ++i) rhs_data[i] = RandomInt8();
+
+  // Each <B, C> matrix of the RHS transposed to <C, B> for the generic kernel.
+  const int depth = rhs_dims[3];
+  const int cols = rhs_dims[4];
+  const int matrices = rhs_shape.FlatSize() / (depth * cols);
+  for (int m = 0; m < matrices; ++m) {
+    const int8_t* in = rhs_data + m * depth * cols;
+    int8_t* out = rhs_transposed + m * depth * cols;
+    for (int k = 0; k < depth; ++k) {
+      for (int c = 0; c < cols; ++c) out[c * depth + k] = in[k * cols + c];
+    }
+  }
+  int rhs_transposed_dims[5] = {rhs_dims[0], rhs_dims[1], rhs_dims[2], cols,
+                                depth};
+  const RuntimeShape rhs_transposed_shape(5, rhs_transposed_dims);
+  // The LHS data stays put, only its shape has its last two dimensions
+  // swapped, as the kernel passes it.
+  int lhs_swapped_dims[5] = {lhs_dims[0], lhs_dims[1], lhs_dims[2],
+                             lhs_dims[4], lhs_dims[3]};
+  const RuntimeShape lhs_swapped_shape(5, lhs_swapped_dims);
+
+  FullyConnectedParams params;
+  params.input_offset = -lhs_zero_point;
+  params.weights_offset = -rhs_zero_point;
+  params.output_offset = 3;
+  params.output_multiplier = 1518500250;  // 0.707 in Q0.31
+  params.output_shift = -7;
+  params.quantized_activation_min = -128;
+  params.quantized_activation_max = 127;
+
+  // The generic kernel takes the transposed RHS first and applies
+  // weights_offset to it, as the BatchMatMul kernel calls it.
+  reference_ops::BatchMatMul<int8_t, int32_t>(
+      params, rhs_transposed_shape, rhs_transposed, lhs_swapped_shape,
+      lhs_data, out_shape, expected);
+  reference_ops::BatchMatMulRowMajorRhs<int8_t, int32_t>(
+      params, lhs_shape, lhs_data, rhs_shape, rhs_data, out_shape, actual);
+
+  for (int i = 0; i < out_shape.FlatSize(); ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], actual[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(RowMajorRhsOddShapes) {
+  const int lhs_dims[] = {1, 1, 1, 3, 5};
+  const int rhs_dims[] = {1, 1, 1, 5, 7};
+  tflite::testing::TestRowMajorRhs(lhs_dims, rhs_dims, 0, 0, 1);
+}
+
+TF_LITE_MICRO_TEST(RowMajorRhsColumnsNotMultipleOf4) {
+  const int lhs_dims[] = {1, 1, 2, 9, 13};
+  const int rhs_dims[] = {1, 1, 2, 13, 10};
+  tflite::testing::TestRowMajorRhs(lhs_dims, rhs_dims, -5, 0, 2);
+}
+
+TF_LITE_MICRO_TEST(RowMajorRhsSingleColumn) {
+  const int lhs_dims[] = {1, 1, 1, 6, 11};
+  const int rhs_dims[] = {1, 1, 1, 11, 1};
+  tflite::testing::TestRowMajorRhs(lhs_dims, rhs_dims, 7, -3, 3);
+}
+
+TF_LITE_MICRO_TEST(RowMajorRhs5DBroadcast) {
+  const int lhs_dims[] = {2, 1, 3, 5, 6};
+  const int rhs_dims[] = {1, 2, 1, 6, 9};
+  tflite::testing::TestRowMajorRhs(lhs_dims, rhs_dims, 12, -1, 4);
+}
+
+TF_LITE_MICRO_TEST(RowMajorRhs5DSameBatches) {
+  const int lhs_dims[] = {2, 2, 2, 4, 8};
+  const int rhs_dims[] = {2, 2, 2, 8, 12};
+  tflite::testing::TestRowMajorRhs(lhs_dims, rhs_dims, -128, 0, 5);
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -0,0 +1,558 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/fused_attention.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/graph_rewrite.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/kernels/mul.h"
+#include "tensorflow/lite/micro/kernels/softmax.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "perf_scope.h"
+
+namespace tflite {
+namespace {
+
+// Inputs of a FUSED_ATTENTION node. kScaleTensor is -1 when the block had no
+// MUL.
+constexpr int kQueryTensor = 0;
+constexpr int kKeyTensor = 1;
+constexpr int kValueTensor = 2;
+constexpr int kScaleTensor = 3;
+constexpr int kNumInputs = 4;
+constexpr int kOutputTensor = 0;
+
+struct OpDataFusedAttention {
+  // scores = query x key, requantized as the first BATCH_MATMUL did.
+  int32_t query_offset;
+  int32_t key_offset;
+  int32_t scores_multiplier;
+  int scores_shift;
+  int32_t scores_zero_point;
+  bool key_adjoint;
+
+  // scores = scores * scale, as the MUL did. Only used with a scale input.
+  int32_t mul_scores_offset;
+  int32_t mul_scale_offset;
+  int32_t mul_output_offset;
+  int32_t mul_multiplier;
+  int mul_shift;
+  int32_t mul_activation_min;
+  int32_t mul_activation_max;
+  bool scale_is_scalar;
+
+  SoftmaxParams softmax;
+
+  // output = probs x value, requantized as the second BATCH_MATMUL did.
+  int32_t probs_offset;
+  int32_t value_offset;
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t output_zero_point;
+  bool value_adjoint;
+
+  // query <batches, rows, depth>, probs <batches, rows, sequence> and
+  // output <batches, rows, value_depth>, batch dimensions flattened.
+  int batches;
+  int rows;
+  int depth;
+  int sequence;
+  int value_depth;
+
+  // Per-row accumulators, scores and probs.
+  int scratch_index;
+};
+
+// Node and tensor indices of a matched attention block. mul and scaled are
+// -1 when the scores go straight into the SOFTMAX.
+struct AttentionBlock {
+  int first;
+  int mul;
+  int softmax;
+  int last;
+
+  int query;
+  int key;
+  int scores;
+  int scale;
+  int scaled;
+  int probs;
+  int value;
+  int output;
+};
+
+// Follows the first BATCH_MATMUL's output through the graph. Only looks at
+// structure; types, shapes and quantization are checked by the caller.
+bool MatchAttentionBlock(MicroGraph& graph, int subgraph,
+                         const TfLiteNode* node, AttentionBlock* block) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+
+  block->first = tflite::micro::NodeIndex(graph, subgraph, node);
+  if (block->first < 0 || node->inputs->size != 2 ||
+      static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data)->adj_x) {
+    return false;
+  }
+  block->query = node->inputs->data[0];
+  block->key = node->inputs->data[1];
+  block->scores = node->outputs->data[0];
+
+  int next = tflite::micro::SoleConsumer(graph, subgraph, block->scores);
+  if (next < 0) {
+    return false;
+  }
+  block->mul = -1;
+  block->scale = -1;
+  block->scaled = -1;
+  if (tflite::micro::IsBuiltin(nodes[next], BuiltinOperator_MUL)) {
+    const TfLiteNode& mul = nodes[next].node;
+    if (mul.inputs->size != 2) {
+      return false;
+    }
+    block->mul = next;
+    block->scale = mul.inputs->data[0] == block->scores ? mul.inputs->data[1]
+                                                         : mul.inputs->data[0];
+    block->scaled = mul.outputs->data[0];
+    if (block->scale == block->scores) {
+      return false;
+    }
+    next = tflite::micro::SoleConsumer(graph, subgraph, block->scaled);
+    if (next < 0) {
+      return false;
+    }
+  }
+
+  if (!tflite::micro::IsBuiltin(nodes[next], BuiltinOperator_SOFTMAX)) {
+    return false;
+  }
+  block->softmax = next;
+  block->probs = nodes[next].node.outputs->data[0];
+
+  next = tflite::micro::SoleConsumer(graph, subgraph, block->probs);
+  if (next < 0 ||
+      !tflite::micro::IsBuiltin(nodes[next], BuiltinOperator_BATCH_MATMUL)) {
+    return false;
+  }
+  const TfLiteNode& last = nodes[next].node;
+  if (last.inputs->size != 2 || last.inputs->data[0] != block->probs ||
+      static_cast<const TfLiteBatchMatMulParams*>(last.builtin_data)->adj_x) {
+    return false;
+  }
+  block->last = next;
+  block->value = last.inputs->data[1];
+  block->output = last.outputs->data[0];
+  return true;
+}
+
+// Temporary TfLiteTensors for the tensors of a block, released on every
+// return path of FuseAttention.
+struct BlockTensors {
+  BlockTensors(MicroContext* micro_context, const AttentionBlock& block)
+      : micro_context_(micro_context),
+        query(Allocate(block.query)),
+        key(Allocate(block.key)),
+        scores(Allocate(block.scores)),
+        scale(Allocate(block.scale)),
+        scaled(Allocate(block.scaled)),
+        probs(Allocate(block.probs)),
+        value(Allocate(block.value)),
+        output(Allocate(block.output)) {}
+
+  ~BlockTensors() {
+    for (TfLiteTensor* tensor :
+         {query, key, scores, scale, scaled, probs, value, output}) {
+      if (tensor != nullptr) {
+        micro_context_->DeallocateTempTfLiteTensor(tensor);
+      }
+    }
+  }
+
+ private:
+  TfLiteTensor* Allocate(int index) {
+    return index < 0 ? nullptr
+                     : micro_context_->AllocateTempTfLiteTensor(index);
+  }
+
+  MicroContext* micro_context_;
+
+ public:
+  TfLiteTensor* query;
+  TfLiteTensor* key;
+  TfLiteTensor* scores;
+  TfLiteTensor* scale;
+  TfLiteTensor* scaled;
+  TfLiteTensor* probs;
+  TfLiteTensor* value;
+  TfLiteTensor* output;
+};
+
+// Checks that the matched block is int8 attention FUSED_ATTENTION handles: all
+// operands of one rank with equal batch dimensions, no broadcasting.
+bool IsSupportedBlock(const BlockTensors& t, bool key_adjoint,
+                      bool value_adjoint) {
+  for (const TfLiteTensor* tensor :
+       {t.query, t.key, t.scores, t.probs, t.value, t.output}) {
+    if (tensor == nullptr || tensor->type != kTfLiteInt8) {
+      return false;
+    }
+  }
+  const int rank = NumDimensions(t.query);
+  if (rank < 2 || rank > 5) {
+    return false;
+  }
+  for (const TfLiteTensor* tensor :
+       {t.key, t.scores, t.probs, t.value, t.output}) {
+    if (NumDimensions(tensor) != rank) {
+      return false;
+    }
+    for (int i = 0; i < rank - 2; ++i) {
+      if (tensor->dims->data[i] != t.query->dims->data[i]) {
+        return false;
+      }
+    }
+  }
+
+  const int rows = SizeOfDimension(t.query, rank - 2);
+  const int depth = SizeOfDimension(t.query, rank - 1);
+  const int sequence = SizeOfDimension(t.scores, rank - 1);
+  const int value_depth = SizeOfDimension(t.output, rank - 1);
+  const int key_depth = SizeOfDimension(t.key, key_adjoint ? rank - 1 : rank - 2);
+  const int key_sequence =
+      SizeOfDimension(t.key, key_adjoint ? rank - 2 : rank - 1);
+  const int value_sequence =
+      SizeOfDimension(t.value, value_adjoint ? rank - 1 : rank - 2);
+  const int value_columns =
+      SizeOfDimension(t.value, value_adjoint ? rank - 2 : rank - 1);
+  if (key_depth != depth || key_sequence != sequence ||
+      SizeOfDimension(t.scores, rank - 2) != rows ||
+      !HaveSameShapes(t.scores, t.probs) || value_sequence != sequence ||
+      value_columns != value_depth ||
+      SizeOfDimension(t.output, rank - 2) != rows) {
+    return false;
+  }
+
+  if (t.scaled != nullptr) {
+    if (t.scale == nullptr || t.scale->type != kTfLiteInt8 ||
+        t.scaled->type != kTfLiteInt8 || !IsConstantTensor(t.scale) ||
+        !HaveSameShapes(t.scores, t.scaled)) {
+      return false;
+    }
+    if (NumElements(t.scale) != 1 && !HaveSameShapes(t.scores, t.scale)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TfLiteStatus FusedAttentionPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_MSG(context, node->user_data != nullptr,
+                     "FUSED_ATTENTION nodes are only created by rewriting "
+                     "BATCH_MATMUL attention blocks.");
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), kNumInputs);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  auto* data = static_cast<OpDataFusedAttention*>(node->user_data);
+
+  const int accumulators =
+      std::max(data->sequence, data->value_depth) * sizeof(int32_t);
+  return context->RequestScratchBufferInArena(
+      context, accumulators + 2 * data->sequence, &data->scratch_index);
+}
+
+TfLiteStatus FusedAttentionEval(TfLiteContext* context, TfLiteNode* node) {
+  const OpDataFusedAttention& data =
+      *static_cast<const OpDataFusedAttention*>(node->user_data);
+  const int8_t* query = tflite::micro::GetTensorData<int8_t>(
+      tflite::micro::GetEvalInput(context, node, kQueryTensor));
+  const int8_t* key = tflite::micro::GetTensorData<int8_t>(
+      tflite::micro::GetEvalInput(context, node, kKeyTensor));
+  const int8_t* value = tflite::micro::GetTensorData<int8_t>(
+      tflite::micro::GetEvalInput(context, node, kValueTensor));
+  const TfLiteEvalTensor* scale_tensor =
+      tflite::micro::GetEvalInput(context, node, kScaleTensor);
+  const int8_t* scale = scale_tensor == nullptr
+                            ? nullptr
+                            : tflite::micro::GetTensorData<int8_t>(scale_tensor);
+  int8_t* output = tflite::micro::GetTensorData<int8_t>(
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor));
+
+  int32_t* accumulators = static_cast<int32_t*>(
+      context->GetScratchBuffer(context, data.scratch_index));
+  int8_t* scores = reinterpret_cast<int8_t*>(
+      accumulators + std::max(data.sequence, data.value_depth));
+  int8_t* probs = scores + data.sequence;
+
+  const int rows = data.rows;
+  const int depth = data.depth;
+  const int sequence = data.sequence;
+  const int value_depth = data.value_depth;
+  const int32_t row_dims[2] = {1, sequence};
+  const RuntimeShape row_shape(2, row_dims);
+
+  // One scope for all heads: a scope per softmax row would be thousands of
+  // entries per inference.
+  PERF_SCOPE("attention");
+  for (int b = 0; b < data.batches; ++b) {
+    const int8_t* batch_query = query + b * rows * depth;
+    const int8_t* batch_key = key + b * depth * sequence;
+    const int8_t* batch_value = value + b * sequence * value_depth;
+    int8_t* batch_output = output + b * rows * value_depth;
+    for (int r = 0; r < rows; ++r) {
+      // One row of scores. Integer sums do not depend on the order of
+      // accumulation, so this matches the first BATCH_MATMUL exactly.
+      const int8_t* query_row = batch_query + r * depth;
+      std::fill(accumulators, accumulators + sequence, 0);
+      if (data.key_adjoint) {
+        for (int s = 0; s < sequence; ++s) {
+          const int8_t* key_row = batch_key + s * depth;
+          int32_t total = 0;
+          for (int d = 0; d < depth; ++d) {
+            total += (query_row[d] + data.query_offset) *
+                     (key_row[d] + data.key_offset);
+          }
+          accumulators[s] = total;
+        }
+      } else {
+        for (int d = 0; d < depth; ++d) {
+          const int32_t q = query_row[d] + data.query_offset;
+          const int8_t* key_row = batch_key + d * sequence;
+          for (int s = 0; s < sequence; ++s) {
+            accumulators[s] += q * (key_row[s] + data.key_offset);
+          }
+        }
+      }
+
+      const int8_t* scale_row =
+          scale == nullptr || data.scale_is_scalar
+              ? scale
+              : scale + (b * rows + r) * sequence;
+      for (int s = 0; s < sequence; ++s) {
+        int32_t score = MultiplyByQuantizedMultiplier(
+                            accumulators[s], data.scores_multiplier,
+                            data.scores_shift) +
+                        data.scores_zero_point;
+        score = std::min<int32_t>(std::max<int32_t>(score, -128), 127);
+        if (scale_row != nullptr) {
+          const int32_t scale_value =
+              scale_row[data.scale_is_scalar ? 0 : s] + data.mul_scale_offset;
+          score = data.mul_output_offset +
+                  MultiplyByQuantizedMultiplier(
+                      (score + data.mul_scores_offset) * scale_value,
+                      data.mul_multiplier, data.mul_shift);
+          score = std::min(data.mul_activation_max,
+                           std::max(data.mul_activation_min, score));
+        }
+        scores[s] = static_cast<int8_t>(score);
+      }
+
+      // The block is int8 throughout, so the exp table is always set.
+      reference_ops::SoftmaxWithExpLut(data.softmax, row_shape, scores,
+                                       row_shape, probs);
+
+      // One row of the output.
+      std::fill(accumulators, accumulators + value_depth, 0);
+      if (data.value_adjoint) {
+        for (int v = 0; v < value_depth; ++v) {
+          const int8_t* value_row = batch_value + v * sequence;
+          int32_t total = 0;
+          for (int s = 0; s < sequence; ++s) {
+            total += (probs[s] + data.probs_offset) *
+                     (value_row[s] + data.value_offset);
+          }
+          accumulators[v] = total;
+        }
+      } else {
+        for (int s = 0; s < sequence; ++s) {
+          const int32_t p = probs[s] + data.probs_offset;
+          const int8_t* value_row = batch_value + s * value_depth;
+          for (int v = 0; v < value_depth; ++v) {
+            accumulators[v] += p * (value_row[v] + data.value_offset);
+          }
+        }
+      }
+      int8_t* output_row = batch_output + r * value_depth;
+      for (int v = 0; v < value_depth; ++v) {
+        const int32_t out =
+            MultiplyByQuantizedMultiplier(accumulators[v],
+                                          data.output_multiplier,
+                                          data.output_shift) +
+            data.output_zero_point;
+        output_row[v] =
+            static_cast<int8_t>(std::min<int32_t>(std::max<int32_t>(out, -128),
+                                                  127));
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus FillOpData(TfLiteContext* context, const NodeAndRegistration* nodes,
+                        const AttentionBlock& block, const BlockTensors& t,
+                        OpDataFusedAttention* data) {
+  const auto* first_params = static_cast<const TfLiteBatchMatMulParams*>(
+      nodes[block.first].node.builtin_data);
+  const auto* last_params = static_cast<const TfLiteBatchMatMulParams*>(
+      nodes[block.last].node.builtin_data);
+  data->key_adjoint = first_params->adj_y;
+  data->value_adjoint = last_params->adj_y;
+
+  double real_multiplier = 0.0;
+  TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
+      context, t.query, t.key, t.scores, &real_multiplier));
+  QuantizeMultiplier(real_multiplier, &data->scores_multiplier,
+                     &data->scores_shift);
+  data->query_offset = -t.query->params.zero_point;
+  data->key_offset = -t.key->params.zero_point;
+  data->scores_zero_point = t.scores->params.zero_point;
+
+  data->scale_is_scalar = false;
+  if (block.mul >= 0) {
+    TfLiteNode* mul = const_cast<TfLiteNode*>(&nodes[block.mul].node);
+    OpDataMul mul_data;
+    TF_LITE_ENSURE_STATUS(CalculateOpDataMul(
+        context, mul, static_cast<TfLiteMulParams*>(mul->builtin_data),
+        &mul_data));
+    const bool scores_first = mul->inputs->data[0] == block.scores;
+    data->mul_scores_offset = -(scores_first ? mul_data.input1_zero_point
+                                             : mul_data.input2_zero_point);
+    data->mul_scale_offset = -(scores_first ? mul_data.input2_zero_point
+                                            : mul_data.input1_zero_point);
+    data->mul_output_offset = mul_data.output_zero_point;
+    data->mul_multiplier = mul_data.output_multiplier;
+    data->mul_shift = mul_data.output_shift;
+    data->mul_activation_min = mul_data.output_activation_min;
+    data->mul_activation_max = mul_data.output_activation_max;
+    data->scale_is_scalar = NumElements(t.scale) == 1;
+  }
+
+  // Only set for int8 input; persistent buffers are not zeroed.
+  data->softmax.exp_lut_int8 = nullptr;
+  TF_LITE_ENSURE_STATUS(CalculateSoftmaxParams(
+      context, t.scaled != nullptr ? t.scaled : t.scores, t.probs,
+      static_cast<const TfLiteSoftmaxParams*>(
+          nodes[block.softmax].node.builtin_data),
+      &data->softmax));
+
+  TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
+      context, t.probs, t.value, t.output, &real_multiplier));
+  QuantizeMultiplier(real_multiplier, &data->output_multiplier,
+                     &data->output_shift);
+  data->probs_offset = -t.probs->params.zero_point;
+  data->value_offset = -t.value->params.zero_point;
+  data->output_zero_point = t.output->params.zero_point;
+
+  const int rank = NumDimensions(t.query);
+  data->batches = 1;
+  for (int i = 0; i < rank - 2; ++i) {
+    data->batches *= SizeOfDimension(t.query, i);
+  }
+  data->rows = SizeOfDimension(t.query, rank - 2);
+  data->depth = SizeOfDimension(t.query, rank - 1);
+  data->sequence = SizeOfDimension(t.scores, rank - 1);
+  data->value_depth = SizeOfDimension(t.output, rank - 1);
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteStatus FuseAttention(TfLiteContext* context, TfLiteNode* node) {
+  MicroContext* micro_context = GetMicroContext(context);
+  MicroGraph& graph = micro_context->graph();
+  // Only rewrite for interpreters whose resolver has the fused op. Kernel
+  // tests run nodes without a graph behind them.
+  if (!tflite::micro::HasCustomOp(graph, "FUSED_ATTENTION") ||
+      graph.GetAllocations() == nullptr) {
+    return kTfLiteOk;
+  }
+  const int subgraph = graph.GetCurrentSubgraphIndex();
+  NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+
+  AttentionBlock block;
+  if (!MatchAttentionBlock(graph, subgraph, node, &block)) {
+    return kTfLiteOk;
+  }
+  BlockTensors tensors(micro_context, block);
+  const bool key_adjoint = static_cast<const TfLiteBatchMatMulParams*>(
+                               node->builtin_data)
+                               ->adj_y;
+  const bool value_adjoint = static_cast<const TfLiteBatchMatMulParams*>(
+                                 nodes[block.last].node.builtin_data)
+                                 ->adj_y;
+  if (!IsSupportedBlock(tensors, key_adjoint, value_adjoint)) {
+    return kTfLiteOk;
+  }
+
+  auto* data = static_cast<OpDataFusedAttention*>(
+      micro_context->AllocatePersistentBuffer(sizeof(OpDataFusedAttention)));
+  TF_LITE_ENSURE(context, data != nullptr);
+  TF_LITE_ENSURE_STATUS(FillOpData(context, nodes, block, tensors, data));
+
+  // The query and key are normally planned to die at the first BATCH_MATMUL.
+  // The memory planner also reads these node inputs, so listing them here
+  // keeps them in the arena up to the last one.
+  TfLiteIntArray* inputs = static_cast<TfLiteIntArray*>(
+      micro_context->AllocatePersistentBuffer(
+          TfLiteIntArrayGetSizeInBytes(kNumInputs)));
+  TF_LITE_ENSURE(context, inputs != nullptr);
+  inputs->size = kNumInputs;
+  inputs->data[kQueryTensor] = block.query;
+  inputs->data[kKeyTensor] = block.key;
+  inputs->data[kValueTensor] = block.value;
+  inputs->data[kScaleTensor] = block.scale;
+
+  for (int tensor : {block.scores, block.scaled, block.probs}) {
+    if (tensor >= 0) {
+      tflite::micro::DropFromPlan(graph, subgraph, tensor);
+    }
+  }
+  for (int absorbed : {block.first, block.mul, block.softmax}) {
+    if (absorbed >= 0) {
+      nodes[absorbed].registration = tflite::micro::AbsorbedRegistration();
+    }
+  }
+  TfLiteNode* fused = &nodes[block.last].node;
+  fused->inputs = inputs;
+  fused->user_data = data;
+  nodes[block.last].registration = Register_FUSED_ATTENTION();
+  return kTfLiteOk;
+}
+
+TfLiteRegistration* Register_FUSED_ATTENTION() {
+  static TfLiteRegistration r = [] {
+    TfLiteRegistration registration = tflite::micro::RegisterOp(
+        nullptr, FusedAttentionPrepare, FusedAttentionEval);
+    registration.builtin_code = BuiltinOperator_CUSTOM;
+    registration.custom_name = "FUSED_ATTENTION";
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace tflite
@@ -0,0 +1,41 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_FUSED_ATTENTION_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_FUSED_ATTENTION_H_
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// Called from the Prepare of an int8 BATCH_MATMUL node. If the node starts an
+// attention block
+//
+//   scores = BATCH_MATMUL(query, key)
+//   scores = MUL(scores, constant)        (optional)
+//   probs  = SOFTMAX(scores)
+//   output = BATCH_MATMUL(probs, value)
+//
+// whose intermediates have no other consumers, the block is rewritten in place
+// into one FUSED_ATTENTION node at the position of the last BATCH_MATMUL. The
+// other nodes are left with a registration that does nothing, and the three
+// intermediates get no arena space. Returns kTfLiteOk when the block does not
+// match or the FUSED_ATTENTION op is not registered; errors only come from
+// failed allocations.
+TfLiteStatus FuseAttention(TfLiteContext* context, TfLiteNode* node);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_FUSED_ATTENTION_H_
@@ -0,0 +1,171 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs BATCH_MATMUL -> [MUL] -> SOFTMAX -> BATCH_MATMUL attention blocks on
+// random int8 data with and without FUSED_ATTENTION in the resolver, and
+// checks that the fused node gives the same output as the four ops.
+
+#include <stdint.h>
+
+#include "tensorflow/lite/micro/kernels/graph_rewrite_test_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kMaxElements = 1024;
+
+int8_t query_data[kMaxElements];
+int8_t key_data[kMaxElements];
+int8_t value_data[kMaxElements];
+int8_t expected[kMaxElements];
+int8_t actual[kMaxElements];
+
+uint32_t random_state;
+
+int8_t RandomInt8() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return static_cast<int8_t>(random_state >> 24);
+}
+
+// Attention over |heads| heads of |rows| queries and |sequence| keys and
+// values. The key is stored <sequence, depth> when |key_adjoint|, as
+// BATCH_MATMUL's adj_y reads it, and the value <value_depth, sequence> when
+// |value_adjoint|.
+void TestAttention(int heads, int rows, int depth, int sequence,
+                   int value_depth, bool key_adjoint, bool value_adjoint,
+                   bool with_mul, uint32_t seed) {
+  const int query_size = heads * rows * depth;
+  const int key_size = heads * depth * sequence;
+  const int value_size = heads * sequence * value_depth;
+  const int output_size = heads * rows * value_depth;
+  TF_LITE_MICRO_EXPECT_LE(query_size, kMaxElements);
+  TF_LITE_MICRO_EXPECT_LE(key_size, kMaxElements);
+  TF_LITE_MICRO_EXPECT_LE(value_size, kMaxElements);
+  TF_LITE_MICRO_EXPECT_LE(output_size, kMaxElements);
+
+  RewriteTestModel model;
+  const int query = model.AddTensor(TensorType_INT8, {1, heads, rows, depth},
+                                    0.05f, -3);
+  const int key =
+      key_adjoint
+          ? model.AddTensor(TensorType_INT8, {1, heads, sequence, depth},
+                            0.04f, 2)
+          : model.AddTensor(TensorType_INT8, {1, heads, depth, sequence},
+                            0.04f, 2);
+  const int value =
+      value_adjoint
+          ? model.AddTensor(TensorType_INT8, {1, heads, value_depth, sequence},
+                            0.05f, 1)
+          : model.AddTensor(TensorType_INT8, {1, heads, sequence, value_depth},
+                            0.05f, 1);
+  const int scores = model.AddTensor(
+      TensorType_INT8, {1, heads, rows, sequence}, 0.1f, 4);
+  const int probs = model.AddTensor(TensorType_INT8, {1, heads, rows, sequence},
+                                    1.0f / 256, -128);
+  const int output = model.AddTensor(
+      TensorType_INT8, {1, heads, rows, value_depth}, 0.02f, -2);
+
+  model.AddOperator(BuiltinOperator_BATCH_MATMUL, {query, key}, {scores},
+                    BuiltinOptions_BatchMatMulOptions,
+                    CreateBatchMatMulOptions(model.builder(), false,
+                                             key_adjoint)
+                        .Union());
+  int softmax_input = scores;
+  if (with_mul) {
+    const int8_t scale_value = 90;
+    const int scale = model.AddTensor(TensorType_INT8, {1}, 1.0f / 256, 0,
+                                      &scale_value, 1);
+    softmax_input = model.AddTensor(TensorType_INT8,
+                                    {1, heads, rows, sequence}, 0.05f, -1);
+    model.AddOperator(BuiltinOperator_MUL, {scores, scale}, {softmax_input},
+                      BuiltinOptions_MulOptions,
+                      CreateMulOptions(model.builder()).Union());
+  }
+  model.AddOperator(BuiltinOperator_SOFTMAX, {softmax_input}, {probs},
+                    BuiltinOptions_SoftmaxOptions,
+                    CreateSoftmaxOptions(model.builder(), 1.0f).Union());
+  model.AddOperator(BuiltinOperator_BATCH_MATMUL, {probs, value}, {output},
+                    BuiltinOptions_BatchMatMulOptions,
+                    CreateBatchMatMulOptions(model.builder(), false,
+                                             value_adjoint)
+                        .Union());
+  const Model* built = model.Build({query, key, value}, {output});
+
+  random_state = seed;
+  for (int i = 0; i < query_size; ++i) query_data[i] = RandomInt8();
+  for (int i = 0; i < key_size; ++i) key_data[i] = RandomInt8();
+  for (int i = 0; i < value_size; ++i) value_data[i] = RandomInt8();
+
+  MicroMutableOpResolver<3> unfused;
+  unfused.AddBatchMatMul();
+  unfused.AddMul();
+  unfused.AddSoftmax();
+  MicroMutableOpResolver<4> fused;
+  fused.AddBatchMatMul();
+  fused.AddMul();
+  fused.AddSoftmax();
+  fused.AddFusedAttention();
+
+  int fused_nodes;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      InvokeRewriteTestModel(built, unfused,
+                             {query_data, key_data, value_data}, expected,
+                             output_size, "FUSED_ATTENTION", &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(0, fused_nodes);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      InvokeRewriteTestModel(built, fused, {query_data, key_data, value_data},
+                             actual, output_size, "FUSED_ATTENTION",
+                             &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(1, fused_nodes);
+
+  for (int i = 0; i < output_size; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], actual[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(FusedAttentionWithMul) {
+  tflite::testing::TestAttention(2, 6, 8, 10, 12, false, false, true, 1);
+}
+
+TF_LITE_MICRO_TEST(FusedAttentionWithoutMul) {
+  tflite::testing::TestAttention(2, 5, 8, 9, 6, false, false, false, 2);
+}
+
+TF_LITE_MICRO_TEST(FusedAttentionKeyAdjoint) {
+  tflite::testing::TestAttention(3, 4, 7, 16, 5, true, false, true, 3);
+}
+
+TF_LITE_MICRO_TEST(FusedAttentionValueAdjoint) {
+  tflite::testing::TestAttention(2, 8, 6, 12, 10, true, true, true, 4);
+}
+
+TF_LITE_MICRO_TEST(FusedAttentionSingleHeadLongSequence) {
+  tflite::testing::TestAttention(1, 4, 16, 64, 8, false, false, true, 5);
+}
+
+TF_LITE_MICRO_TESTS_END
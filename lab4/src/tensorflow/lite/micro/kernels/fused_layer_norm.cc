@@ -0,0 +1,534 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/fused_layer_norm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/add.h"
+#include "tensorflow/lite/micro/kernels/graph_rewrite.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/kernels/mul.h"
+#include "tensorflow/lite/micro/kernels/sub.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kOutputTensor = 0;
+constexpr int kLutSize = 256;
+
+struct OpDataFusedLayerNorm {
+  int depth;
+  OpDataReduce mean;
+  OpDataReduce variance;
+  // SUB(x, mean). The x side is looked up in scaled_input.
+  ArithmeticParams sub;
+  int32_t scaled_input[kLutSize];
+  // MUL(centered, centered), ADD(variance, epsilon) and RSQRT, each indexed by
+  // the bit pattern of its input.
+  int8_t square[kLutSize];
+  int8_t shifted[kLutSize];
+  int32_t rsqrt_input_offset;
+  int8_t rsqrt[kLutSize];
+  // MUL(centered, rstd) with the offsets already matched to the operands.
+  int32_t centered_offset;
+  int32_t rstd_offset;
+  OpDataMul scale;
+};
+
+// Tensors of a matched chain, see fused_layer_norm.h for the names.
+enum ChainTensor {
+  kX,
+  kMeanAxis,
+  kMean,
+  kCentered,
+  kSquared,
+  kVarianceAxis,
+  kVariance,
+  kEpsilon,
+  kShifted,
+  kRstd,
+  kOutput,
+  kNumChainTensors,
+};
+
+struct LayerNormChain {
+  int mean;
+  int sub;
+  int square;
+  int variance;
+  int add;
+  int rsqrt;
+  int mul;
+  int tensors[kNumChainTensors];
+  bool epsilon_first;
+  bool centered_first;
+};
+
+inline uint8_t LutIndex(int8_t value) { return static_cast<uint8_t>(value); }
+
+TfLiteStatus FusedLayerNormPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_MSG(context, node->user_data != nullptr,
+                     "FUSED_LAYER_NORM nodes are only created by rewriting "
+                     "MEAN ... MUL layer norm chains.");
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  return kTfLiteOk;
+}
+
+TfLiteStatus FusedLayerNormEval(TfLiteContext* context, TfLiteNode* node) {
+  const OpDataFusedLayerNorm& data =
+      *static_cast<const OpDataFusedLayerNorm*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  const int depth = data.depth;
+  const int rows = NumElements(input->dims) / depth;
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  const ArithmeticParams& sub = data.sub;
+  const OpDataMul& scale = data.scale;
+
+  for (int row = 0; row < rows; ++row) {
+    int32_t sum = 0;
+    for (int i = 0; i < depth; ++i) {
+      sum += input_data[i];
+    }
+    const int8_t mean = QuantizedMeanOfSum<int8_t>(data.mean, sum, depth);
+    const int32_t scaled_mean = MultiplyByQuantizedMultiplierSmallerThanOneExp(
+        (sub.input2_offset + mean) * (1 << sub.left_shift),
+        sub.input2_multiplier, sub.input2_shift);
+
+    // The centered row goes to the output first and is scaled in place once
+    // the variance is known.
+    int32_t square_sum = 0;
+    for (int i = 0; i < depth; ++i) {
+      const int32_t raw_sub =
+          data.scaled_input[LutIndex(input_data[i])] - scaled_mean;
+      const int32_t centered =
+          std::min(sub.quantized_activation_max,
+                   std::max(sub.quantized_activation_min,
+                            MultiplyByQuantizedMultiplierSmallerThanOneExp(
+                                raw_sub, sub.output_multiplier,
+                                sub.output_shift) +
+                                sub.output_offset));
+      output_data[i] = static_cast<int8_t>(centered);
+      square_sum += data.square[LutIndex(output_data[i])];
+    }
+    const int8_t variance =
+        QuantizedMeanOfSum<int8_t>(data.variance, square_sum, depth);
+    const int8_t shifted = data.shifted[LutIndex(variance)];
+    TF_LITE_ENSURE_MSG(context, shifted >= data.rsqrt_input_offset,
+                       "Rsqrt is only defined for positive values");
+    const int32_t rstd = data.rsqrt[LutIndex(shifted)] + data.rstd_offset;
+
+    for (int i = 0; i < depth; ++i) {
+      const int32_t result =
+          scale.output_zero_point +
+          MultiplyByQuantizedMultiplier(
+              (output_data[i] + data.centered_offset) * rstd,
+              scale.output_multiplier, scale.output_shift);
+      output_data[i] = static_cast<int8_t>(
+          std::min(scale.output_activation_max,
+                   std::max(scale.output_activation_min, result)));
+    }
+    input_data += depth;
+    output_data += depth;
+  }
+  return kTfLiteOk;
+}
+
+// Index of the only node reading |tensor| if it is a |op| with one output, -1
+// otherwise.
+int SoleConsumerOfType(MicroGraph& graph, int subgraph, int tensor,
+                       BuiltinOperator op) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int consumer = tflite::micro::SoleConsumer(graph, subgraph, tensor);
+  if (consumer < 0 || !tflite::micro::IsBuiltin(nodes[consumer], op) ||
+      nodes[consumer].node.outputs->size != 1) {
+    return -1;
+  }
+  return consumer;
+}
+
+// Follows the data flow from the first MEAN, filling in the node and tensor
+// indices. Types and shapes are left to IsSupportedChain().
+bool MatchChain(MicroGraph& graph, int subgraph, int mean,
+                LayerNormChain* chain) {
+  const SubgraphAllocations& allocations = graph.GetAllocations()[subgraph];
+  const NodeAndRegistration* nodes = allocations.node_and_registrations;
+  int* tensors = chain->tensors;
+
+  const TfLiteNode& mean_node = nodes[mean].node;
+  if (mean_node.inputs->size != 2 || mean_node.outputs->size != 1) {
+    return false;
+  }
+  chain->mean = mean;
+  tensors[kX] = mean_node.inputs->data[0];
+  tensors[kMeanAxis] = mean_node.inputs->data[1];
+  tensors[kMean] = mean_node.outputs->data[0];
+
+  chain->sub =
+      SoleConsumerOfType(graph, subgraph, tensors[kMean], BuiltinOperator_SUB);
+  if (chain->sub < 0) {
+    return false;
+  }
+  const TfLiteNode& sub_node = nodes[chain->sub].node;
+  if (sub_node.inputs->size != 2 || sub_node.inputs->data[0] != tensors[kX] ||
+      sub_node.inputs->data[1] != tensors[kMean]) {
+    return false;
+  }
+  tensors[kCentered] = sub_node.outputs->data[0];
+
+  // The centered values feed both the square and the final MUL, and nothing
+  // else.
+  if (tflite::micro::IsSubgraphTensor(graph, subgraph,
+                                      &allocations.tensors[tensors[kCentered]]) ||
+      tflite::micro::NumConsumers(graph, subgraph, tensors[kCentered]) != 2) {
+    return false;
+  }
+  chain->square = -1;
+  chain->mul = -1;
+  const int node_count = graph.NumOperators(subgraph);
+  for (int i = 0; i < node_count; ++i) {
+    const TfLiteNode& consumer = nodes[i].node;
+    if (!tflite::micro::UsesTensor(consumer, tensors[kCentered])) {
+      continue;
+    }
+    if (!tflite::micro::IsBuiltin(nodes[i], BuiltinOperator_MUL) ||
+        consumer.inputs->size != 2 || consumer.outputs->size != 1) {
+      return false;
+    }
+    if (consumer.inputs->data[0] == consumer.inputs->data[1]) {
+      chain->square = i;
+    } else {
+      chain->mul = i;
+    }
+  }
+  if (chain->square < 0 || chain->mul < 0) {
+    return false;
+  }
+  tensors[kSquared] = nodes[chain->square].node.outputs->data[0];
+
+  chain->variance = SoleConsumerOfType(graph, subgraph, tensors[kSquared],
+                                       BuiltinOperator_MEAN);
+  if (chain->variance < 0 ||
+      nodes[chain->variance].node.inputs->size != 2 ||
+      nodes[chain->variance].node.inputs->data[0] != tensors[kSquared]) {
+    return false;
+  }
+  tensors[kVarianceAxis] = nodes[chain->variance].node.inputs->data[1];
+  tensors[kVariance] = nodes[chain->variance].node.outputs->data[0];
+
+  chain->add = SoleConsumerOfType(graph, subgraph, tensors[kVariance],
+                                  BuiltinOperator_ADD);
+  if (chain->add < 0 || nodes[chain->add].node.inputs->size != 2) {
+    return false;
+  }
+  const TfLiteIntArray* add_inputs = nodes[chain->add].node.inputs;
+  chain->epsilon_first = add_inputs->data[1] == tensors[kVariance];
+  tensors[kEpsilon] = add_inputs->data[chain->epsilon_first ? 0 : 1];
+  tensors[kShifted] = nodes[chain->add].node.outputs->data[0];
+
+  chain->rsqrt = SoleConsumerOfType(graph, subgraph, tensors[kShifted],
+                                    BuiltinOperator_RSQRT);
+  if (chain->rsqrt < 0) {
+    return false;
+  }
+  tensors[kRstd] = nodes[chain->rsqrt].node.outputs->data[0];
+
+  if (tflite::micro::SoleConsumer(graph, subgraph, tensors[kRstd]) !=
+      chain->mul) {
+    return false;
+  }
+  const TfLiteNode& mul_node = nodes[chain->mul].node;
+  chain->centered_first = mul_node.inputs->data[0] == tensors[kCentered];
+  tensors[kOutput] = mul_node.outputs->data[0];
+
+  // The fused node reads x at the position of the last MUL, so the memory
+  // plan must keep x alive until then.
+  return tflite::micro::LastConsumer(graph, subgraph, tensors[kX]) > chain->mul;
+}
+
+// True if |axis| is a constant reducing over the innermost of |rank|
+// dimensions.
+bool IsLastAxis(const TfLiteTensor* axis, int rank) {
+  if (!IsConstantTensor(axis) || axis->type != kTfLiteInt32 ||
+      NumElements(axis) != 1) {
+    return false;
+  }
+  const int reduced = GetTensorData<int32_t>(axis)[0];
+  return reduced == rank - 1 || reduced == -1;
+}
+
+bool IsSupportedChain(TfLiteTensor* const* tensors) {
+  for (int i = 0; i < kNumChainTensors; ++i) {
+    if (tensors[i] == nullptr) {
+      return false;
+    }
+    if (i != kMeanAxis && i != kVarianceAxis &&
+        (tensors[i]->type != kTfLiteInt8 ||
+         tensors[i]->quantization.type != kTfLiteAffineQuantization)) {
+      return false;
+    }
+  }
+  const TfLiteTensor* x = tensors[kX];
+  const int rank = NumDimensions(x);
+  if (rank == 0 || SizeOfDimension(x, rank - 1) == 0) {
+    return false;
+  }
+  const int rows = NumElements(x) / SizeOfDimension(x, rank - 1);
+  return HaveSameShapes(x, tensors[kCentered]) &&
+         HaveSameShapes(x, tensors[kSquared]) &&
+         HaveSameShapes(x, tensors[kOutput]) &&
+         NumElements(tensors[kMean]) == rows &&
+         NumElements(tensors[kVariance]) == rows &&
+         NumElements(tensors[kShifted]) == rows &&
+         NumElements(tensors[kRstd]) == rows &&
+         IsLastAxis(tensors[kMeanAxis], rank) &&
+         IsLastAxis(tensors[kVarianceAxis], rank) &&
+         IsConstantTensor(tensors[kEpsilon]) &&
+         NumElements(tensors[kEpsilon]) == 1;
+}
+
+// Fills in |data| so that FusedLayerNormEval() gives the outputs of the
+// unfused kernels.
+TfLiteStatus PopulateOpData(TfLiteContext* context, MicroGraph& graph,
+                            int subgraph, const LayerNormChain& chain,
+                            TfLiteTensor* const* tensors,
+                            const OpDataReduce& mean_data,
+                            OpDataFusedLayerNorm* data) {
+  NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int8_t kMin = std::numeric_limits<int8_t>::min();
+  const int8_t kMax = std::numeric_limits<int8_t>::max();
+
+  data->depth = SizeOfDimension(tensors[kX], NumDimensions(tensors[kX]) - 1);
+  data->mean = mean_data;
+  data->variance.input_zp = tensors[kSquared]->params.zero_point;
+  data->variance.input_scale = tensors[kSquared]->params.scale;
+  data->variance.output_zp = tensors[kVariance]->params.zero_point;
+  data->variance.output_scale = tensors[kVariance]->params.scale;
+
+  OpDataSub sub_data;
+  TF_LITE_ENSURE_STATUS(CalculateOpDataSub(
+      context,
+      static_cast<TfLiteSubParams*>(nodes[chain.sub].node.builtin_data),
+      tensors[kX], tensors[kMean], tensors[kCentered], &sub_data));
+  ArithmeticParams& sub = data->sub;
+  sub.left_shift = sub_data.left_shift;
+  sub.input1_offset = sub_data.input1_offset;
+  sub.input1_multiplier = sub_data.input1_multiplier;
+  sub.input1_shift = sub_data.input1_shift;
+  sub.input2_offset = sub_data.input2_offset;
+  sub.input2_multiplier = sub_data.input2_multiplier;
+  sub.input2_shift = sub_data.input2_shift;
+  sub.output_offset = sub_data.output_offset;
+  sub.output_multiplier = sub_data.output_multiplier;
+  sub.output_shift = sub_data.output_shift;
+  SetActivationParams(sub_data.output_activation_min,
+                      sub_data.output_activation_max, &sub);
+
+  OpDataMul square_data;
+  TF_LITE_ENSURE_STATUS(CalculateOpDataMul(
+      context, &nodes[chain.square].node,
+      static_cast<TfLiteMulParams*>(nodes[chain.square].node.builtin_data),
+      &square_data));
+
+  OpDataAdd add_data;
+  const TfLiteTensor* variance = tensors[kVariance];
+  const TfLiteTensor* epsilon = tensors[kEpsilon];
+  TF_LITE_ENSURE_STATUS(CalculateOpDataAdd(
+      context, static_cast<TfLiteAddParams*>(nodes[chain.add].node.builtin_data),
+      chain.epsilon_first ? epsilon : variance,
+      chain.epsilon_first ? variance : epsilon, tensors[kShifted], &add_data));
+  ArithmeticParams add;
+  add.left_shift = add_data.left_shift;
+  add.input1_offset = add_data.input1_offset;
+  add.input1_multiplier = add_data.input1_multiplier;
+  add.input1_shift = add_data.input1_shift;
+  add.input2_offset = add_data.input2_offset;
+  add.input2_multiplier = add_data.input2_multiplier;
+  add.input2_shift = add_data.input2_shift;
+  add.output_offset = add_data.output_offset;
+  add.output_multiplier = add_data.output_multiplier;
+  add.output_shift = add_data.output_shift;
+  SetActivationParams(add_data.output_activation_min,
+                      add_data.output_activation_max, &add);
+  const int8_t epsilon_value = GetTensorData<int8_t>(epsilon)[0];
+
+  // Same multiplier as the RSQRT kernel computes for itself.
+  int32_t rsqrt_multiplier;
+  int rsqrt_shift;
+  QuantizeMultiplier(1. / static_cast<double>(
+                              (std::sqrt(tensors[kShifted]->params.scale) *
+                               tensors[kRstd]->params.scale)),
+                     &rsqrt_multiplier, &rsqrt_shift);
+  data->rsqrt_input_offset = tensors[kShifted]->params.zero_point;
+  const int32_t rsqrt_output_offset = tensors[kRstd]->params.zero_point;
+  const int32_t kShift = 20;
+
+  for (int i = kMin; i <= kMax; ++i) {
+    const int8_t value = static_cast<int8_t>(i);
+    const uint8_t index = LutIndex(value);
+    data->scaled_input[index] = MultiplyByQuantizedMultiplierSmallerThanOneExp(
+        (sub.input1_offset + i) * (1 << sub.left_shift), sub.input1_multiplier,
+        sub.input1_shift);
+
+    const int32_t centered = i - square_data.input1_zero_point;
+    const int32_t square =
+        square_data.output_zero_point +
+        MultiplyByQuantizedMultiplier(
+            centered * (i - square_data.input2_zero_point),
+            square_data.output_multiplier, square_data.output_shift);
+    data->square[index] = static_cast<int8_t>(
+        std::min(square_data.output_activation_max,
+                 std::max(square_data.output_activation_min, square)));
+
+    data->shifted[index] =
+        chain.epsilon_first
+            ? reference_integer_ops::AddFunc(epsilon_value, value, add)
+            : reference_integer_ops::AddFunc(value, epsilon_value, add);
+
+    const int32_t rsqrt_input = i - data->rsqrt_input_offset;
+    if (rsqrt_input <= 0) {
+      // Zero maps to the largest output like in the RSQRT kernel; negative
+      // inputs are rejected in Eval before the table is read.
+      data->rsqrt[index] = kMax;
+      continue;
+    }
+    int32_t inv_sqrt_multiplier;
+    int inv_sqrt_shift;
+    GetInvSqrtQuantizedMultiplierExp(rsqrt_input, kReverseShift,
+                                     &inv_sqrt_multiplier, &inv_sqrt_shift);
+    const int32_t inv_sqrt = MultiplyByQuantizedMultiplier(
+        static_cast<int32_t>(1), inv_sqrt_multiplier, inv_sqrt_shift + kShift);
+    const int32_t rstd =
+        MultiplyByQuantizedMultiplier(inv_sqrt, rsqrt_multiplier,
+                                      rsqrt_shift - kShift) +
+        rsqrt_output_offset;
+    data->rsqrt[index] = static_cast<int8_t>(
+        std::min<int32_t>(kMax, std::max<int32_t>(kMin, rstd)));
+  }
+
+  TF_LITE_ENSURE_STATUS(CalculateOpDataMul(
+      context, &nodes[chain.mul].node,
+      static_cast<TfLiteMulParams*>(nodes[chain.mul].node.builtin_data),
+      &data->scale));
+  data->centered_offset = -(chain.centered_first
+                                ? data->scale.input1_zero_point
+                                : data->scale.input2_zero_point);
+  data->rstd_offset = -(chain.centered_first ? data->scale.input2_zero_point
+                                             : data->scale.input1_zero_point);
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteStatus FuseLayerNorm(TfLiteContext* context, TfLiteNode* node,
+                           const OpDataReduce& mean_data) {
+  MicroContext* micro_context = GetMicroContext(context);
+  MicroGraph& graph = micro_context->graph();
+  // Only rewrite for interpreters whose resolver has the fused op. Kernel
+  // tests run nodes without a graph behind them.
+  if (!tflite::micro::HasCustomOp(graph, "FUSED_LAYER_NORM") ||
+      graph.GetAllocations() == nullptr) {
+    return kTfLiteOk;
+  }
+  const int subgraph = graph.GetCurrentSubgraphIndex();
+  NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+
+  LayerNormChain chain;
+  const int mean = tflite::micro::NodeIndex(graph, subgraph, node);
+  if (mean < 0 || !MatchChain(graph, subgraph, mean, &chain)) {
+    return kTfLiteOk;
+  }
+
+  TfLiteTensor* tensors[kNumChainTensors];
+  for (int i = 0; i < kNumChainTensors; ++i) {
+    tensors[i] = micro_context->AllocateTempTfLiteTensor(chain.tensors[i]);
+  }
+  OpDataFusedLayerNorm* data = nullptr;
+  TfLiteStatus status = kTfLiteOk;
+  if (IsSupportedChain(tensors)) {
+    data = static_cast<OpDataFusedLayerNorm*>(
+        micro_context->AllocatePersistentBuffer(sizeof(OpDataFusedLayerNorm)));
+    status = data == nullptr ? kTfLiteError
+                             : PopulateOpData(context, graph, subgraph, chain,
+                                              tensors, mean_data, data);
+  }
+  for (int i = 0; i < kNumChainTensors; ++i) {
+    if (tensors[i] != nullptr) {
+      micro_context->DeallocateTempTfLiteTensor(tensors[i]);
+    }
+  }
+  TF_LITE_ENSURE_STATUS(status);
+  if (data == nullptr) {
+    return kTfLiteOk;
+  }
+
+  TfLiteIntArray* inputs = static_cast<TfLiteIntArray*>(
+      micro_context->AllocatePersistentBuffer(
+          TfLiteIntArrayGetSizeInBytes(1)));
+  TF_LITE_ENSURE(context, inputs != nullptr);
+  inputs->size = 1;
+  inputs->data[kInputTensor] = chain.tensors[kX];
+
+  for (const ChainTensor dropped :
+       {kMean, kCentered, kSquared, kVariance, kShifted, kRstd}) {
+    tflite::micro::DropFromPlan(graph, subgraph, chain.tensors[dropped]);
+  }
+  for (const int absorbed : {chain.mean, chain.sub, chain.square,
+                             chain.variance, chain.add, chain.rsqrt}) {
+    nodes[absorbed].registration = tflite::micro::AbsorbedRegistration();
+  }
+  TfLiteNode* fused = &nodes[chain.mul].node;
+  fused->inputs = inputs;
+  fused->user_data = data;
+  nodes[chain.mul].registration = Register_FUSED_LAYER_NORM();
+  return kTfLiteOk;
+}
+
+TfLiteRegistration* Register_FUSED_LAYER_NORM() {
+  static TfLiteRegistration r = [] {
+    TfLiteRegistration registration = tflite::micro::RegisterOp(
+        nullptr, FusedLayerNormPrepare, FusedLayerNormEval);
+    registration.builtin_code = BuiltinOperator_CUSTOM;
+    registration.custom_name = "FUSED_LAYER_NORM";
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace tflite
@@ -0,0 +1,48 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_FUSED_LAYER_NORM_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_FUSED_LAYER_NORM_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/reduce.h"
+
+namespace tflite {
+
+// Called from the Prepare of an int8 MEAN node once |mean_data| is filled in.
+// If the node starts a layer norm over the innermost dimension
+//
+//   mean     = MEAN(x)
+//   centered = SUB(x, mean)
+//   squared  = MUL(centered, centered)
+//   variance = MEAN(squared)
+//   shifted  = ADD(variance, epsilon)
+//   rstd     = RSQRT(shifted)
+//   output   = MUL(centered, rstd)
+//
+// with a constant epsilon and no other consumers of the intermediates, the
+// chain is rewritten into one FUSED_LAYER_NORM node at the position of the
+// last MUL, which makes two passes over each row of x. The other nodes are left
+// with a registration that does nothing and the intermediates get no arena
+// space. x has to stay alive past the chain, as it does when a residual ADD
+// reads it afterwards. Returns kTfLiteOk when the chain does not match or the
+// FUSED_LAYER_NORM op is not registered; errors only come from failed
+// allocations.
+TfLiteStatus FuseLayerNorm(TfLiteContext* context, TfLiteNode* node,
+                           const OpDataReduce& mean_data);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_FUSED_LAYER_NORM_H_
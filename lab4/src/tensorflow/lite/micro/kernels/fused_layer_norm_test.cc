@@ -0,0 +1,176 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs MEAN -> SUB -> MUL -> MEAN -> ADD -> RSQRT -> MUL layer norm chains on
+// random int8 data with and without FUSED_LAYER_NORM in the resolver, and
+// checks that the fused node gives the same output as the seven ops.
+
+#include <stdint.h>
+
+#include "tensorflow/lite/micro/kernels/graph_rewrite_test_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kMaxElements = 1024;
+
+int8_t input_data[kMaxElements];
+int8_t expected[kMaxElements];
+int8_t actual[kMaxElements];
+
+uint32_t random_state;
+
+int8_t RandomInt8() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return static_cast<int8_t>(random_state >> 24);
+}
+
+// Layer norm over the last of the <1, rows, depth> input, reducing over
+// |axis|. |residual| adds the input back after the chain, as transformer
+// blocks do; without that nothing reads the input after the first MUL and
+// the chain must be left alone.
+void TestLayerNorm(int rows, int depth, int32_t axis, float mean_scale,
+                   int32_t mean_zero_point, bool epsilon_first,
+                   bool centered_first, bool residual, uint32_t seed) {
+  const int size = rows * depth;
+  TF_LITE_MICRO_EXPECT_LE(size, kMaxElements);
+
+  RewriteTestModel model;
+  const int x = model.AddTensor(TensorType_INT8, {1, rows, depth}, 0.05f, 0);
+  const int reduce_axis = model.AddInt32Constant({1}, &axis, 1);
+  const int mean = model.AddTensor(TensorType_INT8, {1, rows, 1}, mean_scale,
+                                   mean_zero_point);
+  const int centered =
+      model.AddTensor(TensorType_INT8, {1, rows, depth}, 0.05f, 0);
+  const int squared =
+      model.AddTensor(TensorType_INT8, {1, rows, depth}, 0.25f, -128);
+  const int variance =
+      model.AddTensor(TensorType_INT8, {1, rows, 1}, 0.1f, -128);
+  const int8_t epsilon_value = 1;
+  const int epsilon =
+      model.AddTensor(TensorType_INT8, {1}, 0.1f, 0, &epsilon_value, 1);
+  const int shifted =
+      model.AddTensor(TensorType_INT8, {1, rows, 1}, 0.1f, -128);
+  const int rstd =
+      model.AddTensor(TensorType_INT8, {1, rows, 1}, 1.0f / 256, -128);
+  const int normalized =
+      model.AddTensor(TensorType_INT8, {1, rows, depth}, 0.03f, 0);
+
+  model.AddOperator(BuiltinOperator_MEAN, {x, reduce_axis}, {mean},
+                    BuiltinOptions_ReducerOptions,
+                    CreateReducerOptions(model.builder(), true).Union());
+  model.AddOperator(BuiltinOperator_SUB, {x, mean}, {centered},
+                    BuiltinOptions_SubOptions,
+                    CreateSubOptions(model.builder()).Union());
+  model.AddOperator(BuiltinOperator_MUL, {centered, centered}, {squared},
+                    BuiltinOptions_MulOptions,
+                    CreateMulOptions(model.builder()).Union());
+  model.AddOperator(BuiltinOperator_MEAN, {squared, reduce_axis}, {variance},
+                    BuiltinOptions_ReducerOptions,
+                    CreateReducerOptions(model.builder(), true).Union());
+  if (epsilon_first) {
+    model.AddOperator(BuiltinOperator_ADD, {epsilon, variance}, {shifted},
+                      BuiltinOptions_AddOptions,
+                      CreateAddOptions(model.builder()).Union());
+  } else {
+    model.AddOperator(BuiltinOperator_ADD, {variance, epsilon}, {shifted},
+                      BuiltinOptions_AddOptions,
+                      CreateAddOptions(model.builder()).Union());
+  }
+  model.AddOperator(BuiltinOperator_RSQRT, {shifted}, {rstd});
+  if (centered_first) {
+    model.AddOperator(BuiltinOperator_MUL, {centered, rstd}, {normalized},
+                      BuiltinOptions_MulOptions,
+                      CreateMulOptions(model.builder()).Union());
+  } else {
+    model.AddOperator(BuiltinOperator_MUL, {rstd, centered}, {normalized},
+                      BuiltinOptions_MulOptions,
+                      CreateMulOptions(model.builder()).Union());
+  }
+  int output = normalized;
+  if (residual) {
+    output = model.AddTensor(TensorType_INT8, {1, rows, depth}, 0.08f, 0);
+    model.AddOperator(BuiltinOperator_ADD, {normalized, x}, {output},
+                      BuiltinOptions_AddOptions,
+                      CreateAddOptions(model.builder()).Union());
+  }
+  const Model* built = model.Build({x}, {output});
+
+  random_state = seed;
+  for (int i = 0; i < size; ++i) input_data[i] = RandomInt8();
+
+  MicroMutableOpResolver<5> unfused;
+  unfused.AddMean();
+  unfused.AddSub();
+  unfused.AddMul();
+  unfused.AddAdd();
+  unfused.AddRsqrt();
+  MicroMutableOpResolver<6> fused;
+  fused.AddMean();
+  fused.AddSub();
+  fused.AddMul();
+  fused.AddAdd();
+  fused.AddRsqrt();
+  fused.AddFusedLayerNorm();
+
+  int fused_nodes;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, InvokeRewriteTestModel(built, unfused, {input_data}, expected,
+                                        size, "FUSED_LAYER_NORM",
+                                        &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(0, fused_nodes);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, InvokeRewriteTestModel(built, fused, {input_data}, actual,
+                                        size, "FUSED_LAYER_NORM",
+                                        &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(residual ? 1 : 0, fused_nodes);
+
+  for (int i = 0; i < size; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], actual[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(FusedLayerNormSameMeanQuantization) {
+  tflite::testing::TestLayerNorm(4, 32, 2, 0.05f, 0, false, true, true, 1);
+}
+
+TF_LITE_MICRO_TEST(FusedLayerNormRequantizedMean) {
+  tflite::testing::TestLayerNorm(6, 24, 2, 0.04f, 3, false, true, true, 2);
+}
+
+TF_LITE_MICRO_TEST(FusedLayerNormNegativeAxisSwappedOperands) {
+  tflite::testing::TestLayerNorm(5, 40, -1, 0.05f, 0, true, false, true, 3);
+}
+
+TF_LITE_MICRO_TEST(FusedLayerNormLongRows) {
+  tflite::testing::TestLayerNorm(2, 192, -1, 0.03f, -5, true, true, true, 4);
+}
+
+TF_LITE_MICRO_TEST(FusedLayerNormInputNotKeptAlive) {
+  tflite::testing::TestLayerNorm(4, 32, 2, 0.05f, 0, false, true, false, 5);
+}
+
+TF_LITE_MICRO_TESTS_END
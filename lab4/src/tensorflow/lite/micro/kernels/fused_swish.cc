@@ -0,0 +1,186 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/fused_swish.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/logistic.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/graph_rewrite.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/kernels/mul.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#include "perf_scope.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kOutputTensor = 0;
+
+struct OpDataFusedSwish {
+  // Output for every input, indexed by the input's bit pattern.
+  int8_t lut[reference_integer_ops::kLogisticLutInt8Size];
+};
+
+TfLiteStatus FusedSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_MSG(context, node->user_data != nullptr,
+                     "FUSED_SWISH nodes are only created by rewriting "
+                     "LOGISTIC -> MUL pairs.");
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  return kTfLiteOk;
+}
+
+TfLiteStatus FusedSwishEval(TfLiteContext* context, TfLiteNode* node) {
+  const OpDataFusedSwish& data =
+      *static_cast<const OpDataFusedSwish*>(node->user_data);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  // Same table walk as the int8 Logistic, with the MUL folded into the table.
+  PERF_SCOPE("swish");
+  reference_integer_ops::LogisticLut(
+      data.lut, NumElements(input->dims),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+// Checks that the MUL multiplies the LOGISTIC's input by its output, all int8
+// and of one shape.
+bool IsSupportedPair(MicroContext* micro_context, const TfLiteNode& logistic,
+                     const TfLiteNode& mul) {
+  const int input_index = logistic.inputs->data[0];
+  const int gate_index = logistic.outputs->data[0];
+  if (mul.inputs->size != 2 || mul.outputs->size != 1) {
+    return false;
+  }
+  const int other = mul.inputs->data[0] == gate_index ? mul.inputs->data[1]
+                                                      : mul.inputs->data[0];
+  if (other != input_index) {
+    return false;
+  }
+
+  TfLiteTensor* input = micro_context->AllocateTempTfLiteTensor(input_index);
+  TfLiteTensor* output =
+      micro_context->AllocateTempTfLiteTensor(mul.outputs->data[0]);
+  const bool supported = input != nullptr && output != nullptr &&
+                         input->type == kTfLiteInt8 &&
+                         output->type == kTfLiteInt8 &&
+                         HaveSameShapes(input, output);
+  if (input != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(input);
+  }
+  if (output != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(output);
+  }
+  return supported;
+}
+
+// Evaluates MUL(x, gate) for every int8 x the way the MUL kernel would, with
+// gate = logistic_lut[x].
+void PopulateSwishLut(const OpDataMul& mul, bool gate_first,
+                      const int8_t* logistic_lut, int8_t* lut) {
+  const int32_t input_offset =
+      -(gate_first ? mul.input2_zero_point : mul.input1_zero_point);
+  const int32_t gate_offset =
+      -(gate_first ? mul.input1_zero_point : mul.input2_zero_point);
+  for (int i = std::numeric_limits<int8_t>::min();
+       i <= std::numeric_limits<int8_t>::max(); ++i) {
+    const uint8_t index = static_cast<uint8_t>(i);
+    const int32_t product =
+        (i + input_offset) * (logistic_lut[index] + gate_offset);
+    const int32_t result =
+        mul.output_zero_point +
+        MultiplyByQuantizedMultiplier(product, mul.output_multiplier,
+                                      mul.output_shift);
+    lut[index] = static_cast<int8_t>(std::min(
+        mul.output_activation_max, std::max(mul.output_activation_min, result)));
+  }
+}
+
+}  // namespace
+
+TfLiteStatus FuseSwish(TfLiteContext* context, TfLiteNode* node,
+                       const int8_t* logistic_lut) {
+  MicroContext* micro_context = GetMicroContext(context);
+  MicroGraph& graph = micro_context->graph();
+  // Only rewrite for interpreters whose resolver has the fused op. Kernel
+  // tests run nodes without a graph behind them.
+  if (!tflite::micro::HasCustomOp(graph, "FUSED_SWISH") ||
+      graph.GetAllocations() == nullptr) {
+    return kTfLiteOk;
+  }
+  const int subgraph = graph.GetCurrentSubgraphIndex();
+  NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+
+  const int logistic = tflite::micro::NodeIndex(graph, subgraph, node);
+  if (logistic < 0 || node->inputs->size != 1 || node->outputs->size != 1) {
+    return kTfLiteOk;
+  }
+  const int gate = node->outputs->data[0];
+  const int mul = tflite::micro::SoleConsumer(graph, subgraph, gate);
+  if (mul < 0 || !tflite::micro::IsBuiltin(nodes[mul], BuiltinOperator_MUL) ||
+      !IsSupportedPair(micro_context, *node, nodes[mul].node)) {
+    return kTfLiteOk;
+  }
+  TfLiteNode* fused = &nodes[mul].node;
+
+  OpDataMul mul_data;
+  TF_LITE_ENSURE_STATUS(CalculateOpDataMul(
+      context, fused, static_cast<TfLiteMulParams*>(fused->builtin_data),
+      &mul_data));
+  auto* data = static_cast<OpDataFusedSwish*>(
+      micro_context->AllocatePersistentBuffer(sizeof(OpDataFusedSwish)));
+  TF_LITE_ENSURE(context, data != nullptr);
+  PopulateSwishLut(mul_data, fused->inputs->data[0] == gate, logistic_lut,
+                   data->lut);
+
+  // The MUL's inputs are (x, gate) or (gate, x); the fused node reads only x,
+  // which node->inputs still points at.
+  tflite::micro::DropFromPlan(graph, subgraph, gate);
+  nodes[logistic].registration = tflite::micro::AbsorbedRegistration();
+  fused->inputs = node->inputs;
+  fused->user_data = data;
+  nodes[mul].registration = Register_FUSED_SWISH();
+  return kTfLiteOk;
+}
+
+TfLiteRegistration* Register_FUSED_SWISH() {
+  static TfLiteRegistration r = [] {
+    TfLiteRegistration registration =
+        tflite::micro::RegisterOp(nullptr, FusedSwishPrepare, FusedSwishEval);
+    registration.builtin_code = BuiltinOperator_CUSTOM;
+    registration.custom_name = "FUSED_SWISH";
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace tflite
@@ -0,0 +1,42 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_FUSED_SWISH_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_FUSED_SWISH_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// Called from the Prepare of an int8 LOGISTIC node, once |logistic_lut| holds
+// its output for every input. If the node is half of a Swish
+//
+//   gate   = LOGISTIC(x)
+//   output = MUL(x, gate)
+//
+// and the gate has no other consumer, the pair is rewritten into one
+// FUSED_SWISH node at the position of the MUL, which looks every output up in
+// a table built from both ops' quantization. The LOGISTIC node is left with a
+// registration that does nothing and the gate gets no arena space. Returns
+// kTfLiteOk when the pair does not match or the FUSED_SWISH op is not
+// registered; errors only come from failed allocations.
+TfLiteStatus FuseSwish(TfLiteContext* context, TfLiteNode* node,
+                       const int8_t* logistic_lut);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_FUSED_SWISH_H_
@@ -0,0 +1,112 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs LOGISTIC -> MUL Swish pairs over every int8 input with and without
+// FUSED_SWISH in the resolver, and checks that the table PopulateSwishLut()
+// builds gives the same output as the two ops.
+
+#include <stdint.h>
+
+#include "tensorflow/lite/micro/kernels/graph_rewrite_test_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kSize = 256;
+
+int8_t input_data[kSize];
+int8_t expected[kSize];
+int8_t actual[kSize];
+
+// |gate_first| puts the LOGISTIC output first in the MUL, as MUL(gate, x).
+void TestSwish(float input_scale, int32_t input_zero_point,
+               float output_scale, int32_t output_zero_point,
+               bool gate_first) {
+  RewriteTestModel model;
+  const int input =
+      model.AddTensor(TensorType_INT8, {1, 4, kSize / 4}, input_scale,
+                      input_zero_point);
+  const int gate =
+      model.AddTensor(TensorType_INT8, {1, 4, kSize / 4}, 1.0f / 256, -128);
+  const int output =
+      model.AddTensor(TensorType_INT8, {1, 4, kSize / 4}, output_scale,
+                      output_zero_point);
+  model.AddOperator(BuiltinOperator_LOGISTIC, {input}, {gate});
+  if (gate_first) {
+    model.AddOperator(BuiltinOperator_MUL, {gate, input}, {output},
+                      BuiltinOptions_MulOptions,
+                      CreateMulOptions(model.builder()).Union());
+  } else {
+    model.AddOperator(BuiltinOperator_MUL, {input, gate}, {output},
+                      BuiltinOptions_MulOptions,
+                      CreateMulOptions(model.builder()).Union());
+  }
+  const Model* built = model.Build({input}, {output});
+
+  for (int i = 0; i < kSize; ++i) {
+    input_data[i] = static_cast<int8_t>(i - 128);
+  }
+
+  MicroMutableOpResolver<2> unfused;
+  unfused.AddLogistic();
+  unfused.AddMul();
+  MicroMutableOpResolver<3> fused;
+  fused.AddLogistic();
+  fused.AddMul();
+  fused.AddFusedSwish();
+
+  int fused_nodes;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, InvokeRewriteTestModel(built, unfused, {input_data}, expected,
+                                        kSize, "FUSED_SWISH", &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(0, fused_nodes);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, InvokeRewriteTestModel(built, fused, {input_data}, actual,
+                                        kSize, "FUSED_SWISH", &fused_nodes));
+  TF_LITE_MICRO_EXPECT_EQ(1, fused_nodes);
+
+  for (int i = 0; i < kSize; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], actual[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(FusedSwishInputFirst) {
+  tflite::testing::TestSwish(0.05f, -10, 0.03f, -90, false);
+}
+
+TF_LITE_MICRO_TEST(FusedSwishGateFirst) {
+  tflite::testing::TestSwish(0.05f, -10, 0.03f, -90, true);
+}
+
+TF_LITE_MICRO_TEST(FusedSwishWideInput) {
+  tflite::testing::TestSwish(0.1f, 25, 0.08f, -100, false);
+}
+
+TF_LITE_MICRO_TEST(FusedSwishSaturatingOutput) {
+  tflite::testing::TestSwish(0.04f, 0, 0.01f, -20, true);
+}
+
+TF_LITE_MICRO_TESTS_END
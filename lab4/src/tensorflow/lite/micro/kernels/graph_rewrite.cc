@@ -0,0 +1,158 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/graph_rewrite.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+
+namespace tflite {
+namespace micro {
+namespace {
+
+// Data pointer of the tensors dropped by DropFromPlan(). Being non-null keeps
+// the memory planner from placing them.
+int8_t dropped_tensor_data;
+
+TfLiteStatus AbsorbedEval(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+bool HasCustomOp(MicroGraph& graph, const char* name) {
+  const MicroOpResolver* op_resolver = graph.GetOpResolver();
+  return op_resolver != nullptr && op_resolver->FindOp(name) != nullptr;
+}
+
+bool UsesTensor(const TfLiteNode& node, int tensor) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    if (node.inputs->data[i] == tensor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsSubgraphTensor(MicroGraph& graph, int subgraph,
+                      const TfLiteEvalTensor* tensor) {
+  for (size_t i = 0; i < graph.NumSubgraphInputs(subgraph); ++i) {
+    if (graph.GetSubgraphInput(subgraph, i) == tensor) {
+      return true;
+    }
+  }
+  for (size_t i = 0; i < graph.NumSubgraphOutputs(subgraph); ++i) {
+    if (graph.GetSubgraphOutput(subgraph, i) == tensor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int NodeIndex(MicroGraph& graph, int subgraph, const TfLiteNode* node) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int node_count = graph.NumOperators(subgraph);
+  for (int i = 0; i < node_count; ++i) {
+    if (&nodes[i].node == node) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int Producer(MicroGraph& graph, int subgraph, int tensor) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int node_count = graph.NumOperators(subgraph);
+  for (int i = 0; i < node_count; ++i) {
+    const TfLiteIntArray* outputs = nodes[i].node.outputs;
+    for (int j = 0; j < outputs->size; ++j) {
+      if (outputs->data[j] == tensor) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+int LastConsumer(MicroGraph& graph, int subgraph, int tensor) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int node_count = graph.NumOperators(subgraph);
+  int last = -1;
+  for (int i = 0; i < node_count; ++i) {
+    if (UsesTensor(nodes[i].node, tensor)) {
+      last = i;
+    }
+  }
+  return last;
+}
+
+int NumConsumers(MicroGraph& graph, int subgraph, int tensor) {
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[subgraph].node_and_registrations;
+  const int node_count = graph.NumOperators(subgraph);
+  int count = 0;
+  for (int i = 0; i < node_count; ++i) {
+    if (UsesTensor(nodes[i].node, tensor)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+int SoleConsumer(MicroGraph& graph, int subgraph, int tensor) {
+  const SubgraphAllocations& allocations = graph.GetAllocations()[subgraph];
+  if (IsSubgraphTensor(graph, subgraph, &allocations.tensors[tensor])) {
+    return -1;
+  }
+  const int node_count = graph.NumOperators(subgraph);
+  int consumer = -1;
+  for (int i = 0; i < node_count; ++i) {
+    if (UsesTensor(allocations.node_and_registrations[i].node, tensor)) {
+      if (consumer != -1) {
+        return -1;
+      }
+      consumer = i;
+    }
+  }
+  return consumer;
+}
+
+bool IsBuiltin(const NodeAndRegistration& node, BuiltinOperator op) {
+  return node.registration->builtin_code == op;
+}
+
+void DropFromPlan(MicroGraph& graph, int subgraph, int tensor) {
+  graph.GetAllocations()[subgraph].tensors[tensor].data.data =
+      &dropped_tensor_data;
+}
+
+TfLiteRegistration* AbsorbedRegistration() {
+  static TfLiteRegistration r = [] {
+    TfLiteRegistration registration =
+        RegisterOp(nullptr, nullptr, AbsorbedEval);
+    registration.builtin_code = BuiltinOperator_CUSTOM;
+    registration.custom_name = "FUSED_PART";
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace micro
+}  // namespace tflite
@@ -0,0 +1,74 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+// Helpers for kernels that fuse a chain of nodes at Prepare time. The fused op
+// takes over the node_and_registrations entry of one node of the chain; the
+// other nodes get AbsorbedRegistration() and the tensors only used inside the
+// chain are dropped from the memory plan.
+
+namespace tflite {
+namespace micro {
+
+// True if the resolver of the interpreter running |graph| has the custom op
+// |name|, i.e. the graph may be rewritten to use it. False in kernel tests,
+// which run nodes without an interpreter.
+bool HasCustomOp(MicroGraph& graph, const char* name);
+
+// True if |node| reads |tensor|.
+bool UsesTensor(const TfLiteNode& node, int tensor);
+
+// True if |tensor| is an input or output of |subgraph|.
+bool IsSubgraphTensor(MicroGraph& graph, int subgraph,
+                      const TfLiteEvalTensor* tensor);
+
+// Index of |node| in |subgraph|, or -1 if it is not one of its nodes (as in
+// kernel tests, which run nodes without a graph).
+int NodeIndex(MicroGraph& graph, int subgraph, const TfLiteNode* node);
+
+// Index of the node writing |tensor|, or -1 if none does.
+int Producer(MicroGraph& graph, int subgraph, int tensor);
+
+// Index of the last node reading |tensor|, or -1 if none does.
+int LastConsumer(MicroGraph& graph, int subgraph, int tensor);
+
+// Number of nodes reading |tensor|.
+int NumConsumers(MicroGraph& graph, int subgraph, int tensor);
+
+// Index of the only node reading |tensor|, or -1 if it has no consumer, more
+// than one, or is a subgraph input or output.
+int SoleConsumer(MicroGraph& graph, int subgraph, int tensor);
+
+bool IsBuiltin(const NodeAndRegistration& node, BuiltinOperator op);
+
+// Keeps the memory planner from placing |tensor|. Its data must never be read
+// or written afterwards.
+void DropFromPlan(MicroGraph& graph, int subgraph, int tensor);
+
+// Registration for nodes whose work a fused node took over: no Prepare, and
+// an Eval that does nothing.
+TfLiteRegistration* AbsorbedRegistration();
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_H_
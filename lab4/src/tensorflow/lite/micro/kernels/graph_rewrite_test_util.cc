@@ -0,0 +1,171 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/graph_rewrite_test_util.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr size_t kArenaSize = 64 * 1024;
+alignas(16) uint8_t arena[kArenaSize];
+
+// The flatbuffers library vendored here has no default allocator. The builder
+// asks for all of kModelSize up front, so it is only called once per model.
+constexpr size_t kModelSize = 16 * 1024;
+
+class ModelAllocator : public flatbuffers::Allocator {
+ public:
+  uint8_t* allocate(size_t size) override {
+    TFLITE_DCHECK(size <= kModelSize);
+    return data_;
+  }
+  void deallocate(uint8_t* p, size_t) override {}
+
+ private:
+  alignas(16) uint8_t data_[kModelSize];
+};
+
+ModelAllocator model_allocator;
+
+}  // namespace
+
+RewriteTestModel::RewriteTestModel() : builder_(kModelSize, &model_allocator) {
+  // Buffer 0 is the empty buffer of every non-constant tensor.
+  buffers_[buffer_count_++] = CreateBuffer(builder_);
+}
+
+int RewriteTestModel::AddTensor(TensorType type,
+                                std::initializer_list<int32_t> shape,
+                                float scale, int32_t zero_point,
+                                const void* data, size_t bytes) {
+  const int64_t zero_point64 = zero_point;
+  return AddTensor(type, shape,
+                   CreateQuantizationParameters(
+                       builder_, 0, 0, builder_.CreateVector(&scale, 1),
+                       builder_.CreateVector(&zero_point64, 1)),
+                   data, bytes);
+}
+
+int RewriteTestModel::AddInt32Constant(std::initializer_list<int32_t> shape,
+                                       const int32_t* data, size_t count) {
+  return AddTensor(TensorType_INT32, shape, 0, data, count * sizeof(int32_t));
+}
+
+int RewriteTestModel::AddTensor(
+    TensorType type, std::initializer_list<int32_t> shape,
+    flatbuffers::Offset<QuantizationParameters> quantization, const void* data,
+    size_t bytes) {
+  TFLITE_DCHECK(tensor_count_ < kMaxTensors);
+  uint32_t buffer = 0;
+  if (data != nullptr) {
+    builder_.ForceVectorAlignment(bytes, sizeof(uint8_t), 16);
+    buffer = buffer_count_;
+    buffers_[buffer_count_++] = CreateBuffer(
+        builder_,
+        builder_.CreateVector(static_cast<const uint8_t*>(data), bytes));
+  }
+  tensors_[tensor_count_] =
+      CreateTensor(builder_, builder_.CreateVector(shape.begin(), shape.size()),
+                   type, buffer, 0, quantization);
+  return tensor_count_++;
+}
+
+void RewriteTestModel::AddOperator(BuiltinOperator op,
+                                   std::initializer_list<int> inputs,
+                                   std::initializer_list<int> outputs,
+                                   BuiltinOptions options_type,
+                                   flatbuffers::Offset<void> options) {
+  TFLITE_DCHECK(operator_count_ < kMaxOperators);
+  int opcode_index = 0;
+  while (opcode_index < operator_code_count_ &&
+         operator_code_ops_[opcode_index] != op) {
+    ++opcode_index;
+  }
+  if (opcode_index == operator_code_count_) {
+    operator_code_ops_[operator_code_count_] = op;
+    operator_codes_[operator_code_count_++] = CreateOperatorCode(
+        builder_,
+        static_cast<int8_t>(op < BuiltinOperator_PLACEHOLDER_FOR_GREATER_OP_CODES
+                                ? op
+                                : BuiltinOperator_PLACEHOLDER_FOR_GREATER_OP_CODES),
+        0, 1, op);
+  }
+  operators_[operator_count_++] = CreateOperator(
+      builder_, opcode_index,
+      builder_.CreateVector(inputs.begin(), inputs.size()),
+      builder_.CreateVector(outputs.begin(), outputs.size()), options_type,
+      options);
+}
+
+const Model* RewriteTestModel::Build(std::initializer_list<int> inputs,
+                                     std::initializer_list<int> outputs) {
+  const flatbuffers::Offset<SubGraph> subgraph = CreateSubGraph(
+      builder_, builder_.CreateVector(tensors_, tensor_count_),
+      builder_.CreateVector(inputs.begin(), inputs.size()),
+      builder_.CreateVector(outputs.begin(), outputs.size()),
+      builder_.CreateVector(operators_, operator_count_));
+  builder_.Finish(CreateModel(
+      builder_, TFLITE_SCHEMA_VERSION,
+      builder_.CreateVector(operator_codes_, operator_code_count_),
+      builder_.CreateVector(&subgraph, 1), 0,
+      builder_.CreateVector(buffers_, buffer_count_)));
+  return GetModel(builder_.GetBufferPointer());
+}
+
+TfLiteStatus InvokeRewriteTestModel(const Model* model,
+                                    const MicroOpResolver& op_resolver,
+                                    std::initializer_list<const int8_t*> inputs,
+                                    int8_t* output, size_t output_size,
+                                    const char* fused_op, int* fused_nodes) {
+  MicroInterpreter interpreter(model, op_resolver, arena, kArenaSize);
+  TF_LITE_ENSURE_STATUS(interpreter.AllocateTensors());
+
+  int index = 0;
+  for (const int8_t* data : inputs) {
+    TfLiteTensor* input = interpreter.input(index++);
+    std::memcpy(input->data.int8, data, input->bytes);
+  }
+  TF_LITE_ENSURE_STATUS(interpreter.Invoke());
+  const TfLiteTensor* result = interpreter.output(0);
+  if (result->bytes != output_size) {
+    MicroPrintf("Output has %d bytes, expected %d", result->bytes,
+                output_size);
+    return kTfLiteError;
+  }
+  std::memcpy(output, result->data.int8, output_size);
+
+  MicroGraph& graph = interpreter.graph();
+  const NodeAndRegistration* nodes =
+      graph.GetAllocations()[0].node_and_registrations;
+  *fused_nodes = 0;
+  for (uint32_t i = 0; i < graph.NumOperators(0); ++i) {
+    const char* name = nodes[i].registration->custom_name;
+    if (name != nullptr && std::strcmp(name, fused_op) == 0) {
+      ++*fused_nodes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace testing
+}  // namespace tflite
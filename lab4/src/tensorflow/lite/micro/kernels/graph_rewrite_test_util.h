@@ -0,0 +1,97 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_TEST_UTIL_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_TEST_UTIL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+// Helpers for the tests of the kernels that fuse a chain of nodes at Prepare
+// time. Kernel tests run nodes without a graph, so these build a small model
+// instead and run it through a MicroInterpreter, once with a resolver that has
+// the fused op and once with one that does not.
+
+namespace tflite {
+namespace testing {
+
+// Builds a model with one subgraph. The model lives in the builder and is only
+// valid as long as this object. All models share one static buffer, so only
+// one can exist at a time.
+class RewriteTestModel {
+ public:
+  static constexpr int kMaxTensors = 24;
+  static constexpr int kMaxOperators = 12;
+
+  RewriteTestModel();
+
+  // Adds a per-tensor quantized tensor and returns its index. |data| makes it
+  // a constant with |bytes| of data.
+  int AddTensor(TensorType type, std::initializer_list<int32_t> shape,
+                float scale, int32_t zero_point, const void* data = nullptr,
+                size_t bytes = 0);
+
+  // Adds an int32 constant without quantization, e.g. a reduction axis.
+  int AddInt32Constant(std::initializer_list<int32_t> shape,
+                       const int32_t* data, size_t count);
+
+  // For building the options passed to AddOperator().
+  flatbuffers::FlatBufferBuilder& builder() { return builder_; }
+
+  void AddOperator(BuiltinOperator op, std::initializer_list<int> inputs,
+                   std::initializer_list<int> outputs,
+                   BuiltinOptions options_type = BuiltinOptions_NONE,
+                   flatbuffers::Offset<void> options = 0);
+
+  const Model* Build(std::initializer_list<int> inputs,
+                     std::initializer_list<int> outputs);
+
+ private:
+  int AddTensor(TensorType type, std::initializer_list<int32_t> shape,
+                flatbuffers::Offset<QuantizationParameters> quantization,
+                const void* data, size_t bytes);
+
+  flatbuffers::FlatBufferBuilder builder_;
+  flatbuffers::Offset<Tensor> tensors_[kMaxTensors];
+  flatbuffers::Offset<Buffer> buffers_[kMaxTensors + 1];
+  flatbuffers::Offset<Operator> operators_[kMaxOperators];
+  flatbuffers::Offset<OperatorCode> operator_codes_[kMaxOperators];
+  BuiltinOperator operator_code_ops_[kMaxOperators];
+  int tensor_count_ = 0;
+  int buffer_count_ = 0;
+  int operator_count_ = 0;
+  int operator_code_count_ = 0;
+};
+
+// Runs |model| once with |op_resolver|. |inputs| holds the data of each int8
+// model input in order; the first output is copied to |output|, which must
+// hold |output_size| bytes. |fused_nodes| is set to the number of nodes that
+// ended up with the custom op |fused_op|.
+TfLiteStatus InvokeRewriteTestModel(const Model* model,
+                                    const MicroOpResolver& op_resolver,
+                                    std::initializer_list<const int8_t*> inputs,
+                                    int8_t* output, size_t output_size,
+                                    const char* fused_op, int* fused_nodes);
+
+}  // namespace testing
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_GRAPH_REWRITE_TEST_UTIL_H_
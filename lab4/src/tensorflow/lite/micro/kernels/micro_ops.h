@@ -95,6 +95,9 @@ TfLiteRegistration Register_VAR_HANDLE();
 TfLiteRegistration Register_WHILE();
 TfLiteRegistration Register_ZEROS_LIKE();
 TfLiteRegistration Register_BATCH_MATMUL();
+TfLiteRegistration* Register_FUSED_ATTENTION();
+TfLiteRegistration* Register_FUSED_SWISH();
+TfLiteRegistration* Register_FUSED_LAYER_NORM();
 
 namespace ops {
 namespace micro {
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_REDUCE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_REDUCE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/cppmath.h"
+#include "tensorflow/lite/kernels/internal/max.h"
+#include "tensorflow/lite/kernels/internal/min.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+
+extern const int kMaxNumberOfAxis;
+extern const int kMaxNumberOfReducedAxis;
+
+struct OpDataReduce {
+  int32_t multiplier;
+  int shift;
+  int temp_buffer_idx;
+  int resolved_axis_idx;
+  int input_zp;
+  float input_scale;
+  int output_zp;
+  float output_scale;
+  int num_output_elements;
+  int num_axis;
+};
+
+TfLiteStatus PrepareMaxHelper(TfLiteContext* context, TfLiteNode* node,
+                              OpDataReduce* op_data);
+
+TfLiteStatus PrepareMeanOrSumHelper(TfLiteContext* context, TfLiteNode* node,
+                                    OpDataReduce* op_data);
+
+TfLiteStatus EvalMaxHelper(TfLiteContext* context, TfLiteNode* node,
+                           OpDataReduce* op_data);
+TfLiteStatus EvalMeanHelper(TfLiteContext* context, TfLiteNode* node,
+                            OpDataReduce* op_data);
+TfLiteStatus EvalSumHelper(TfLiteContext* context, TfLiteNode* node,
+                           OpDataReduce* op_data);
+
+// Output of an integer MEAN for the int32 sum of |count| inputs, rounded the
+// same way as the generic reducer.
+template <typename T>
+inline T QuantizedMeanOfSum(const OpDataReduce& op_data, int32_t sum,
+                            int32_t count) {
+  if (op_data.input_zp == op_data.output_zp &&
+      op_data.input_scale == op_data.output_scale) {
+    return static_cast<T>(sum / count);
+  }
+  const float scale = op_data.input_scale / op_data.output_scale;
+  const float bias = -op_data.input_zp * scale;
+  const float float_mean =
+      static_cast<float>(sum) / static_cast<float>(count);
+  float result =
+      TfLiteMin(TfLiteRound(float_mean * scale + bias) + op_data.output_zp,
+                static_cast<float>(std::numeric_limits<T>::max()));
+  result = TfLiteMax(result, static_cast<float>(std::numeric_limits<T>::min()));
+  return static_cast<T>(result);
+}
+
+void ReduceResolveAxis(const int* axis_data, int axis_count,
+                       MeanParams* op_params);
+
+TfLiteRegistration Register_MEAN();
+TfLiteRegistration Register_REDUCE_MAX();
+TfLiteRegistration Register_SUM();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_REDUCE_H_
@@ -77,6 +77,16 @@ const float golden_2d_wide[] = {0.128851250, 0.157379270, 0.192223474, 0.2347822
                                 0.286763728, 0.286763698, 0.234782279, 0.192223474, 
                                 0.157379270, 0.128851250};
 
+// Rows with repeated values spread over a wide range.
+const int flat_size_2d_repeated = 16;
+int shape_2d_repeated[] = {2, 2, 8};
+const float input_data_2d_repeated[] = {0.6, -0.4, 0.6, 0.1, -0.4, -1.2, 0.1, 0.6,
+                                        -0.9, 0.3, 0.3, -0.9, 0.3, -0.05, -1.25, -0.05};
+const float golden_2d_repeated[] = {0.195537097, 0.071934078, 0.195537097, 0.118599244,
+                                    0.071934078, 0.032322065, 0.118599244, 0.195537097,
+                                    0.057655721, 0.191423735, 0.191423735, 0.057655721,
+                                    0.191423735, 0.134894026, 0.040629300, 0.134894026};
+
 template <typename T>
 void ValidateSoftmaxGoldens(TfLiteTensor* tensors, const int tensor_count,
                             T* output_data, const T* expected_output,
@@ -194,4 +204,19 @@ TF_LITE_MICRO_TEST(Softmax2DWideQuantizedInt8ShouldMatchGolden) {
       tflite::testing::output_zero_point_int8, output_data);
 }
 
+TF_LITE_MICRO_TEST(Softmax2DRepeatedQuantizedInt8ShouldMatchGolden) {
+  const float input_scale = 0.01f;
+  const int input_zero_point = 0;
+
+  int8_t input_quantized[tflite::testing::flat_size_2d_repeated];
+  int8_t golden_quantized[tflite::testing::flat_size_2d_repeated];
+  int8_t output_data[tflite::testing::flat_size_2d_repeated];
+  tflite::testing::TestSoftmaxQuantized(
+      tflite::testing::shape_2d_repeated, tflite::testing::input_data_2d_repeated,
+      input_quantized, input_scale, input_zero_point, tflite::testing::shape_2d_repeated,
+      tflite::testing::golden_2d_repeated, golden_quantized,
+      tflite::testing::output_scale_int8,
+      tflite::testing::output_zero_point_int8, output_data);
+}
+
 TF_LITE_MICRO_TESTS_END
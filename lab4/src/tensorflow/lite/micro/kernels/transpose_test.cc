@@ -0,0 +1,178 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks reference_ops::Transpose, which canonicalizes the permutation and
+// picks the blocked 2-D, 4x4 word or contiguous run path, against the plain
+// recursive TransposeImpl walk over the original shape.
+
+#include <stdint.h>
+
+#include <array>
+
+#include "tensorflow/lite/kernels/internal/reference/transpose.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kMaxElements = 4096;
+
+// One spare element in front so that the word path can be given a misaligned
+// buffer.
+alignas(4) int32_t input_words[kMaxElements + 1];
+alignas(4) int32_t expected_words[kMaxElements + 1];
+alignas(4) int32_t actual_words[kMaxElements + 1];
+
+uint32_t random_state;
+
+uint32_t RandomWord() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state;
+}
+
+template <typename T>
+void TestTranspose(const int* shape, const int* perm, int dims,
+                   bool misaligned = false) {
+  const int offset = misaligned ? 1 : 0;
+  T* input = reinterpret_cast<T*>(input_words) + offset;
+  T* expected = reinterpret_cast<T*>(expected_words) + offset;
+  T* actual = reinterpret_cast<T*>(actual_words) + offset;
+
+  const RuntimeShape input_shape(dims, shape);
+  int output_dims[kTransposeMaxDimensions];
+  for (int i = 0; i < dims; ++i) output_dims[i] = shape[perm[i]];
+  const RuntimeShape output_shape(dims, output_dims);
+  const int size = input_shape.FlatSize();
+  TF_LITE_MICRO_EXPECT_LE(size, kMaxElements);
+
+  random_state = size;
+  for (int i = 0; i < size; ++i) input[i] = static_cast<T>(RandomWord());
+  for (int i = 0; i < size; ++i) actual[i] = 0;
+
+  std::array<int, kTransposeMaxDimensions> input_stride, output_stride;
+  int32_t shape32[kTransposeMaxDimensions];
+  int32_t perm32[kTransposeMaxDimensions];
+  int32_t output_shape32[kTransposeMaxDimensions];
+  for (int i = 0; i < dims; ++i) {
+    shape32[i] = shape[i];
+    perm32[i] = perm[i];
+    output_shape32[i] = output_dims[i];
+  }
+  reference_ops::transpose_internal::SetupTransposeStrides(input_stride,
+                                                           shape32, dims);
+  reference_ops::transpose_internal::SetupTransposeStrides(
+      output_stride, output_shape32, dims);
+  reference_ops::transpose_internal::TransposeImpl(
+      0, dims, perm32, input, input_stride.data(), expected,
+      output_stride.data(), output_shape32);
+
+  TransposeParams params;
+  params.perm_count = dims;
+  for (int i = 0; i < dims; ++i) params.perm[i] = perm[i];
+  reference_ops::Transpose(params, input_shape, input, output_shape, actual);
+
+  for (int i = 0; i < size; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], actual[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(Transpose2DOddInt8) {
+  const int shape[] = {5, 7};
+  const int perm[] = {1, 0};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 2);
+}
+
+TF_LITE_MICRO_TEST(Transpose2DNotMultipleOf4Int8) {
+  const int shape[] = {6, 10};
+  const int perm[] = {1, 0};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 2);
+}
+
+TF_LITE_MICRO_TEST(Transpose2DWordsInt8) {
+  const int shape[] = {8, 12};
+  const int perm[] = {1, 0};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 2);
+}
+
+TF_LITE_MICRO_TEST(Transpose2DWordsAcrossBlocksInt8) {
+  const int shape[] = {40, 68};
+  const int perm[] = {1, 0};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 2);
+}
+
+TF_LITE_MICRO_TEST(Transpose2DMisalignedInt8) {
+  const int shape[] = {8, 12};
+  const int perm[] = {1, 0};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 2, true);
+}
+
+TF_LITE_MICRO_TEST(TransposeBatched2DInt8) {
+  const int shape[] = {3, 36, 20};
+  const int perm[] = {0, 2, 1};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 3);
+}
+
+TF_LITE_MICRO_TEST(TransposeNhwcToNchwInt8) {
+  const int shape[] = {2, 5, 6, 3};
+  const int perm[] = {0, 3, 1, 2};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 4);
+}
+
+TF_LITE_MICRO_TEST(TransposeNchwToNhwcInt16) {
+  const int shape[] = {1, 3, 7, 5};
+  const int perm[] = {0, 2, 3, 1};
+  tflite::testing::TestTranspose<int16_t>(shape, perm, 4);
+}
+
+TF_LITE_MICRO_TEST(TransposeRuns5DInt8) {
+  const int shape[] = {2, 3, 1, 4, 5};
+  const int perm[] = {1, 0, 3, 2, 4};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 5);
+}
+
+TF_LITE_MICRO_TEST(TransposeRunsPatchUnfoldInt8) {
+  const int shape[] = {4, 2, 4, 2, 6};
+  const int perm[] = {1, 3, 0, 2, 4};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 5);
+}
+
+TF_LITE_MICRO_TEST(TransposeGeneric5DInt8) {
+  const int shape[] = {2, 3, 4, 1, 5};
+  const int perm[] = {4, 2, 0, 3, 1};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 5);
+}
+
+TF_LITE_MICRO_TEST(TransposeGeneric5DInt32) {
+  const int shape[] = {3, 1, 2, 5, 3};
+  const int perm[] = {3, 0, 4, 1, 2};
+  tflite::testing::TestTranspose<int32_t>(shape, perm, 5);
+}
+
+TF_LITE_MICRO_TEST(TransposeSize1DimsOnlyInt8) {
+  const int shape[] = {1, 3, 1, 4};
+  const int perm[] = {2, 1, 0, 3};
+  tflite::testing::TestTranspose<int8_t>(shape, perm, 4);
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -610,6 +610,24 @@ class MicroMutableOpResolver : public MicroOpResolver {
   TfLiteStatus AddBatchMatMul() {
     return AddBuiltin(BuiltinOperator_BATCH_MATMUL, Register_BATCH_MATMUL(), ParseBatchMatMul);
   }
+
+  // Also lets BATCH_MATMUL rewrite int8 BATCH_MATMUL -> [MUL] -> SOFTMAX ->
+  // BATCH_MATMUL attention blocks into this op at Prepare time.
+  TfLiteStatus AddFusedAttention() {
+    return AddCustom("FUSED_ATTENTION", tflite::Register_FUSED_ATTENTION());
+  }
+
+  // Also lets int8 LOGISTIC rewrite LOGISTIC -> MUL Swish pairs into this op
+  // at Prepare time.
+  TfLiteStatus AddFusedSwish() {
+    return AddCustom("FUSED_SWISH", tflite::Register_FUSED_SWISH());
+  }
+
+  // Also lets int8 MEAN rewrite MEAN ... MUL layer norm chains into this op at
+  // Prepare time.
+  TfLiteStatus AddFusedLayerNorm() {
+    return AddCustom("FUSED_LAYER_NORM", tflite::Register_FUSED_LAYER_NORM());
+  }
   /********************** new_add *********************/
 
   unsigned int GetRegistrationLength() { return registrations_len_; }
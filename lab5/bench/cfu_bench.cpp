@@ -0,0 +1,260 @@
+//
+// Copyright 2021 The CFU-Playground Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Host-side throughput bench for the lab5 Cfu/TPU.
+//
+// Drives the verilated Cfu through the same cmd/rsp handshake the CPU uses,
+// runs a sweep of int8 GEMM shapes tiled onto the TPU buffers, checks every
+// result against a plain C++ GEMM and reports cycles per MAC, CFU
+// instructions per tile and where the cycles went:
+//
+//   fill    - ops 1..11 (parameters and buffer A/B writes)
+//   compute - op 12 (in_valid until busy drops)
+//   drain   - ops 14..17 (buffer C reads)
+//
+// Usage: cfu_bench [num_random_shapes [seed]]
+// Exits non-zero if any shape disagrees with the reference.
+
+#include <verilated.h>
+#include "Vcfu.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Limits from cfu.v / TPU.v: 12-bit buffer indices, 8-bit K/M/N.
+constexpr int kBufferDepth = 1 << 12;
+constexpr int kMaxDim = 252;  // largest multiple of 4 that fits in 8 bits
+constexpr uint64_t kCallTimeout = 1 << 20;
+
+enum Phase { kFill, kCompute, kDrain, kNumPhases };
+
+struct Shape {
+  int M, K, N;
+};
+
+// Hand-picked shapes: the functional test, odd edges that exercise partial
+// 4x4 tiles, and shapes that need more than one tile per dimension.
+const Shape kFixedShapes[] = {
+    {16, 16, 16}, {4, 4, 4},    {5, 7, 3},    {64, 64, 64},
+    {49, 72, 8},  {100, 27, 16}, {196, 144, 24}, {300, 300, 40},
+};
+
+class CfuDriver {
+ public:
+  CfuDriver() : top_(new Vcfu), cycles_(0), calls_(0) {
+    top_->clk = 0;
+    top_->cmd_valid = 0;
+    top_->rsp_ready = 1;
+    top_->reset = 1;
+    for (int i = 0; i < 4; ++i) Tick();
+    top_->reset = 0;
+    Tick();
+  }
+  ~CfuDriver() {
+    top_->final();
+    delete top_;
+  }
+
+  uint32_t Call(int op, uint32_t in0, uint32_t in1) {
+    const uint64_t start = cycles_;
+    top_->cmd_payload_function_id = op << 3;
+    top_->cmd_payload_inputs_0 = in0;
+    top_->cmd_payload_inputs_1 = in1;
+    top_->cmd_valid = 1;
+    while (!top_->cmd_ready) Tick(start);
+    top_->cmd_valid = 0;
+    while (!top_->rsp_valid) Tick(start);
+    const uint32_t result = top_->rsp_payload_outputs_0;
+    while (top_->rsp_valid) Tick(start);
+
+    const Phase phase = (op == 12) ? kCompute : (op >= 14) ? kDrain : kFill;
+    phase_cycles_[phase] += cycles_ - start;
+    ++calls_;
+    return result;
+  }
+
+  uint64_t cycles() const { return cycles_; }
+  uint64_t calls() const { return calls_; }
+  uint64_t phase_cycles(Phase p) const { return phase_cycles_[p]; }
+  void ResetStats() {
+    cycles_ = calls_ = 0;
+    std::fill(phase_cycles_, phase_cycles_ + kNumPhases, 0);
+  }
+
+ private:
+  void Tick(uint64_t start = 0) {
+    top_->clk = 1;
+    top_->eval();
+    top_->clk = 0;
+    top_->eval();
+    if (++cycles_ - start > kCallTimeout) {
+      fprintf(stderr, "CFU call timed out after %llu cycles\n",
+              (unsigned long long)kCallTimeout);
+      exit(2);
+    }
+  }
+
+  Vcfu* top_;
+  uint64_t cycles_;
+  uint64_t calls_;
+  uint64_t phase_cycles_[kNumPhases] = {};
+};
+
+inline uint32_t Pack(int8_t b0, int8_t b1, int8_t b2, int8_t b3) {
+  return (uint32_t)(uint8_t)b0 << 24 | (uint32_t)(uint8_t)b1 << 16 |
+         (uint32_t)(uint8_t)b2 << 8 | (uint32_t)(uint8_t)b3;
+}
+
+// Splits |n| into |parts| chunks of near-equal size.
+inline int ChunkSize(int n, int limit) {
+  const int parts = (n + limit - 1) / limit;
+  return (n + parts - 1) / parts;
+}
+
+struct Result {
+  uint64_t tiles;
+  bool ok;
+};
+
+// C[M][N] = A[M][K] * B[K][N], tiled so every tile fits buffers A, B and C.
+Result RunGemm(CfuDriver* cfu, const Shape& s, const std::vector<int8_t>& a,
+               const std::vector<int8_t>& b, std::vector<int32_t>* c) {
+  const int kt = ChunkSize(s.K, kMaxDim);
+  int mt = std::min(kMaxDim, (kBufferDepth / kt) * 4);
+  int nt = std::min(kMaxDim, (kBufferDepth / kt) * 4);
+  // Buffer C holds ceil(nt / 4) * mt words.
+  while (mt * ((nt + 3) / 4) > kBufferDepth) nt -= 4;
+  mt = ChunkSize(s.M, mt);
+  nt = ChunkSize(s.N, nt);
+
+  std::fill(c->begin(), c->end(), 0);
+  uint64_t tiles = 0;
+  cfu->Call(1, 0, 0);
+  for (int k0 = 0; k0 < s.K; k0 += kt) {
+    const int kk = std::min(kt, s.K - k0);
+    cfu->Call(2, kk, kk);
+    for (int m0 = 0; m0 < s.M; m0 += mt) {
+      const int mm = std::min(mt, s.M - m0);
+      cfu->Call(4, mm, mm);
+      for (int n0 = 0; n0 < s.N; n0 += nt) {
+        const int nn = std::min(nt, s.N - n0);
+        cfu->Call(6, nn, nn);
+
+        auto at = [&](int m, int k) -> int8_t {
+          return m < mm ? a[(m0 + m) * s.K + k0 + k] : 0;
+        };
+        auto bt = [&](int k, int n) -> int8_t {
+          return n < nn ? b[(k0 + k) * s.N + n0 + n] : 0;
+        };
+        for (int blk = 0; blk < (mm + 3) / 4; ++blk) {
+          for (int k = 0; k < kk; ++k) {
+            const int m = blk * 4;
+            cfu->Call(8, blk * kk + k,
+                      Pack(at(m, k), at(m + 1, k), at(m + 2, k), at(m + 3, k)));
+          }
+        }
+        for (int blk = 0; blk < (nn + 3) / 4; ++blk) {
+          for (int k = 0; k < kk; ++k) {
+            const int n = blk * 4;
+            cfu->Call(10, blk * kk + k,
+                      Pack(bt(k, n), bt(k, n + 1), bt(k, n + 2), bt(k, n + 3)));
+          }
+        }
+
+        cfu->Call(12, 0, 0);
+
+        for (int blk = 0; blk < (nn + 3) / 4; ++blk) {
+          for (int m = 0; m < mm; ++m) {
+            for (int j = 0; j < 4 && blk * 4 + j < nn; ++j) {
+              (*c)[(m0 + m) * s.N + n0 + blk * 4 + j] +=
+                  (int32_t)cfu->Call(17 - j, blk * mm + m, 0);
+            }
+          }
+        }
+        ++tiles;
+      }
+    }
+  }
+
+  bool ok = true;
+  for (int m = 0; m < s.M && ok; ++m) {
+    for (int n = 0; n < s.N && ok; ++n) {
+      int32_t expected = 0;
+      for (int k = 0; k < s.K; ++k) {
+        expected += a[m * s.K + k] * b[k * s.N + n];
+      }
+      if ((*c)[m * s.N + n] != expected) {
+        printf("  mismatch M=%d K=%d N=%d at C[%d][%d]: got %ld want %ld\n",
+               s.M, s.K, s.N, m, n, (long)(*c)[m * s.N + n], (long)expected);
+        ok = false;
+      }
+    }
+  }
+  return {tiles, ok};
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+  const int num_random = argc > 1 ? atoi(argv[1]) : 16;
+  const unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+  srand(seed);
+
+  std::vector<Shape> shapes(std::begin(kFixedShapes), std::end(kFixedShapes));
+  for (int i = 0; i < num_random; ++i) {
+    // K >= 2: the controller special-cases K == 1.
+    shapes.push_back({1 + rand() % 256, 2 + rand() % 300, 1 + rand() % 64});
+  }
+
+  CfuDriver cfu;
+  int failures = 0;
+  printf("seed %u\n", seed);
+  printf("    M    K    N |     MACs |     cycles | cyc/MAC | tiles | "
+         "insn/tile |  fill%% | comp%% | drain%% |\n");
+  printf("----------------+----------+------------+---------+-------+"
+         "-----------+--------+-------+--------+\n");
+  for (const Shape& s : shapes) {
+    std::vector<int8_t> a(s.M * s.K), b(s.K * s.N);
+    std::vector<int32_t> c(s.M * s.N);
+    for (auto& v : a) v = (int8_t)(rand() & 0xff);
+    for (auto& v : b) v = (int8_t)(rand() & 0xff);
+
+    cfu.ResetStats();
+    const Result r = RunGemm(&cfu, s, a, b, &c);
+    failures += !r.ok;
+
+    const uint64_t macs = (uint64_t)s.M * s.K * s.N;
+    const double total = (double)cfu.cycles();
+    printf(" %4d %4d %4d | %8llu | %10llu | %7.3f | %5llu | %9.1f | %5.1f%% "
+           "| %4.1f%% | %5.1f%% | %s\n",
+           s.M, s.K, s.N, (unsigned long long)macs,
+           (unsigned long long)cfu.cycles(), total / macs,
+           (unsigned long long)r.tiles, (double)cfu.calls() / r.tiles,
+           100.0 * cfu.phase_cycles(kFill) / total,
+           100.0 * cfu.phase_cycles(kCompute) / total,
+           100.0 * cfu.phase_cycles(kDrain) / total, r.ok ? "ok" : "FAIL");
+  }
+
+  printf("\n%zu shapes, %d failed\n", shapes.size(), failures);
+  return failures ? 1 : 0;
+}
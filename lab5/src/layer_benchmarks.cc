@@ -0,0 +1,742 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "layer_benchmarks.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base.h"
+#include "perf.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/kernels/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+enum OpKind { kConv, kDepthwise, kFullyConnected, kBatchMatMul };
+
+struct Dims3 {
+  int h, w, c;
+};
+
+struct Dims2 {
+  int h, w;
+};
+
+// One distinct layer shape. Fully connected and batch matmul layers are
+// folded to |in.h| rows of depth |in.c| giving |out.c| units.
+struct LayerShape {
+  OpKind op;
+  // Models the shape was found in
+  const char* models;
+  // Layers of that shape
+  int uses;
+  Dims3 in;
+  Dims2 window;
+  Dims3 out;
+  Dims2 stride;
+  Dims2 dilation;
+};
+
+// Every distinct conv, depthwise conv, fully connected and batch matmul shape
+// in pdti8, mnv2 (mobilenetv2_160_035), ds_cnn_stream_fe and mobileViT_xxs,
+// read from their .tflite files.
+const LayerShape kShapes[] = {
+    {kConv, "pdti8", 1, {1, 1, 256}, {1, 1}, {1, 1, 2}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {3, 3, 128}, {1, 1}, {3, 3, 256}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {3, 3, 256}, {1, 1}, {3, 3, 256}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 80}, {1, 1}, {4, 4, 96}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 80}, {1, 1}, {4, 4, 320}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 80}, {3, 3}, {4, 4, 80}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 96}, {1, 1}, {4, 4, 80}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 128}, {1, 1}, {4, 4, 80}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {4, 4, 160}, {3, 3}, {4, 4, 80}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 3, {5, 5, 56}, {1, 1}, {5, 5, 336}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {5, 5, 112}, {1, 1}, {5, 5, 1280}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {5, 5, 192}, {1, 1}, {5, 5, 56}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 2, {5, 5, 336}, {1, 1}, {5, 5, 56}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {5, 5, 336}, {1, 1}, {5, 5, 112}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {6, 6, 64}, {1, 1}, {6, 6, 128}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 5, {6, 6, 128}, {1, 1}, {6, 6, 128}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 64}, {1, 1}, {8, 8, 80}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 64}, {1, 1}, {8, 8, 128}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 64}, {3, 3}, {8, 8, 64}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 80}, {1, 1}, {8, 8, 64}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 96}, {1, 1}, {8, 8, 64}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {8, 8, 128}, {3, 3}, {8, 8, 64}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 4, {10, 10, 24}, {1, 1}, {10, 10, 144}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 3, {10, 10, 32}, {1, 1}, {10, 10, 192}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {10, 10, 96}, {1, 1}, {10, 10, 24}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 3, {10, 10, 144}, {1, 1}, {10, 10, 24}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {10, 10, 144}, {1, 1}, {10, 10, 32}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 2, {10, 10, 192}, {1, 1}, {10, 10, 32}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {12, 12, 32}, {1, 1}, {12, 12, 64}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {12, 12, 64}, {1, 1}, {12, 12, 64}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {13, 4, 300}, {1, 1}, {13, 4, 300}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 48}, {1, 1}, {16, 16, 48}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 48}, {1, 1}, {16, 16, 64}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 48}, {1, 1}, {16, 16, 96}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 48}, {3, 3}, {16, 16, 48}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 64}, {1, 1}, {16, 16, 48}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {16, 16, 96}, {3, 3}, {16, 16, 48}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 3, {20, 20, 16}, {1, 1}, {20, 20, 96}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {20, 20, 48}, {1, 1}, {20, 20, 16}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 2, {20, 20, 96}, {1, 1}, {20, 20, 16}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {22, 6, 300}, {1, 1}, {22, 6, 300}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {24, 24, 16}, {1, 1}, {24, 24, 32}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {24, 24, 32}, {1, 1}, {24, 24, 32}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {30, 10, 300}, {1, 1}, {30, 10, 300}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 3, {32, 32, 24}, {1, 1}, {32, 32, 48}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {32, 32, 32}, {1, 1}, {32, 32, 24}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 2, {32, 32, 48}, {1, 1}, {32, 32, 24}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {39, 12, 300}, {1, 1}, {39, 12, 300}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 2, {40, 40, 8}, {1, 1}, {40, 40, 48}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 2, {40, 40, 48}, {1, 1}, {40, 40, 8}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {43, 16, 300}, {1, 1}, {43, 16, 300}, {1, 1}, {1, 1}},
+    {kConv, "pdti8", 1, {48, 48, 8}, {1, 1}, {48, 48, 16}, {1, 1}, {1, 1}},
+    {kConv, "ds_cnn", 1, {49, 20, 1}, {3, 3}, {45, 18, 300}, {1, 1}, {2, 1}},
+    {kConv, "mobilevit", 2, {64, 64, 16}, {1, 1}, {64, 64, 32}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {64, 64, 32}, {1, 1}, {64, 64, 16}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {80, 80, 8}, {1, 1}, {80, 80, 48}, {1, 1}, {1, 1}},
+    {kConv, "mnv2", 1, {80, 80, 16}, {1, 1}, {80, 80, 8}, {1, 1}, {1, 1}},
+    {kConv, "mobilevit", 1, {130, 130, 3}, {3, 3}, {64, 64, 16}, {2, 2},
+     {1, 1}},
+    {kConv, "mnv2", 1, {160, 160, 3}, {3, 3}, {80, 80, 16}, {2, 2}, {1, 1}},
+    {kDepthwise, "pdti8", 1, {3, 3, 256}, {3, 3}, {3, 3, 256}, {1, 1}, {1, 1}},
+    {kDepthwise, "mnv2", 3, {5, 5, 336}, {3, 3}, {5, 5, 336}, {1, 1}, {1, 1}},
+    {kDepthwise, "pdti8", 1, {6, 6, 128}, {3, 3}, {3, 3, 128}, {2, 2}, {1, 1}},
+    {kDepthwise, "pdti8", 5, {6, 6, 128}, {3, 3}, {6, 6, 128}, {1, 1}, {1, 1}},
+    {kDepthwise, "mobilevit", 1, {10, 10, 128}, {3, 3}, {4, 4, 128}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "mnv2", 4, {10, 10, 144}, {3, 3}, {10, 10, 144}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "mnv2", 1, {10, 10, 192}, {3, 3}, {5, 5, 192}, {2, 2}, {1, 1}},
+    {kDepthwise, "mnv2", 2, {10, 10, 192}, {3, 3}, {10, 10, 192}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "pdti8", 1, {12, 12, 64}, {3, 3}, {6, 6, 64}, {2, 2}, {1, 1}},
+    {kDepthwise, "pdti8", 1, {12, 12, 64}, {3, 3}, {12, 12, 64}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "mobilevit", 1, {18, 18, 96}, {3, 3}, {8, 8, 96}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "mnv2", 1, {20, 20, 96}, {3, 3}, {10, 10, 96}, {2, 2}, {1, 1}},
+    {kDepthwise, "mnv2", 2, {20, 20, 96}, {3, 3}, {20, 20, 96}, {1, 1}, {1, 1}},
+    {kDepthwise, "ds_cnn", 1, {22, 6, 300}, {10, 3}, {13, 4, 300}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "pdti8", 1, {24, 24, 32}, {3, 3}, {12, 12, 32}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "pdti8", 1, {24, 24, 32}, {3, 3}, {24, 24, 32}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "ds_cnn", 1, {30, 10, 300}, {5, 3}, {22, 6, 300}, {1, 1},
+     {2, 2}},
+    {kDepthwise, "mobilevit", 2, {32, 32, 48}, {3, 3}, {32, 32, 48}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "mobilevit", 1, {34, 34, 48}, {3, 3}, {16, 16, 48}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "ds_cnn", 1, {39, 12, 300}, {10, 3}, {30, 10, 300}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "mnv2", 1, {40, 40, 48}, {3, 3}, {20, 20, 48}, {2, 2}, {1, 1}},
+    {kDepthwise, "mnv2", 1, {40, 40, 48}, {3, 3}, {40, 40, 48}, {1, 1}, {1, 1}},
+    {kDepthwise, "ds_cnn", 1, {43, 16, 300}, {3, 3}, {39, 12, 300}, {1, 1},
+     {2, 2}},
+    {kDepthwise, "ds_cnn", 1, {45, 18, 300}, {3, 3}, {43, 16, 300}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "pdti8", 1, {48, 48, 8}, {3, 3}, {48, 48, 8}, {1, 1}, {1, 1}},
+    {kDepthwise, "pdti8", 1, {48, 48, 16}, {3, 3}, {24, 24, 16}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "mobilevit", 1, {64, 64, 32}, {3, 3}, {64, 64, 32}, {1, 1},
+     {1, 1}},
+    {kDepthwise, "mobilevit", 1, {66, 66, 32}, {3, 3}, {32, 32, 32}, {2, 2},
+     {1, 1}},
+    {kDepthwise, "mnv2", 1, {80, 80, 16}, {3, 3}, {80, 80, 16}, {1, 1}, {1, 1}},
+    {kDepthwise, "mnv2", 1, {80, 80, 48}, {3, 3}, {40, 40, 48}, {2, 2}, {1, 1}},
+    {kDepthwise, "pdti8", 1, {96, 96, 1}, {3, 3}, {48, 48, 8}, {2, 2}, {1, 1}},
+    {kFullyConnected, "ds_cnn", 1, {1, 1, 300}, {1, 1}, {1, 1, 12}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 1, {1, 1, 320}, {1, 1}, {1, 1, 10}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mnv2", 1, {1, 1, 1280}, {1, 1}, {1, 1, 2}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 3, {16, 1, 32}, {1, 1}, {16, 1, 96}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 3, {16, 1, 96}, {1, 1}, {16, 1, 96}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 3, {16, 1, 96}, {1, 1}, {16, 1, 384},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 3, {16, 1, 384}, {1, 1}, {16, 1, 96},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 4, {64, 1, 32}, {1, 1}, {64, 1, 80}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 4, {64, 1, 80}, {1, 1}, {64, 1, 96}, {1, 1},
+     {1, 1}},
+    {kFullyConnected, "mobilevit", 4, {64, 1, 80}, {1, 1}, {64, 1, 320},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 4, {64, 1, 320}, {1, 1}, {64, 1, 80},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 2, {256, 1, 32}, {1, 1}, {256, 1, 64},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 2, {256, 1, 64}, {1, 1}, {256, 1, 96},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 2, {256, 1, 64}, {1, 1}, {256, 1, 128},
+     {1, 1}, {1, 1}},
+    {kFullyConnected, "mobilevit", 2, {256, 1, 128}, {1, 1}, {256, 1, 64},
+     {1, 1}, {1, 1}},
+    {kBatchMatMul, "mobilevit", 3, {64, 1, 4}, {1, 1}, {64, 1, 8}, {1, 1},
+     {1, 1}},
+    {kBatchMatMul, "mobilevit", 3, {64, 1, 8}, {1, 1}, {64, 1, 4}, {1, 1},
+     {1, 1}},
+    {kBatchMatMul, "mobilevit", 4, {256, 1, 8}, {1, 1}, {256, 1, 16}, {1, 1},
+     {1, 1}},
+    {kBatchMatMul, "mobilevit", 4, {256, 1, 16}, {1, 1}, {256, 1, 8}, {1, 1},
+     {1, 1}},
+    {kBatchMatMul, "mobilevit", 2, {1024, 1, 8}, {1, 1}, {1024, 1, 64}, {1, 1},
+     {1, 1}},
+    {kBatchMatMul, "mobilevit", 2, {1024, 1, 64}, {1, 1}, {1024, 1, 8}, {1, 1},
+     {1, 1}},
+};
+
+// Largest tensors of any shape above
+constexpr int kMaxActivationBytes = 80 * 80 * 48;
+constexpr int kMaxFilterBytes = 1280 * 112;
+constexpr int kMaxChannels = 1280;
+
+// The TPU conv builds its im2col matrices in 1024 x 1024 arrays, and its
+// A buffer holds 4 rows of the reduction depth in 4096 entries.
+constexpr int kTpuMaxDim = 1024;
+
+constexpr float kInputScale = 0.5f;
+constexpr float kFilterScale = 0.25f;
+constexpr int kInputZeroPoint = -3;
+constexpr int kOutputZeroPoint = 5;
+
+int8_t input_data[kMaxActivationBytes];
+int8_t filter_data[kMaxFilterBytes];
+int32_t bias_data[kMaxChannels];
+int8_t output_data[kMaxActivationBytes];
+int8_t stock_output_data[kMaxActivationBytes];
+int32_t output_multiplier[kMaxChannels];
+int32_t output_shift[kMaxChannels];
+
+// What happened to one shape
+struct Result {
+  // Fastest run of the registered kernel and of the stock reference, or 0 if
+  // not run
+  uint64_t kernel_cycles;
+  uint64_t stock_cycles;
+  const char* check;
+};
+
+uint32_t random_state;
+
+// xorshift32, seeded per shape so that every run sees the same data.
+uint32_t next_random() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+void fill_random(int8_t* data, int size) {
+  for (int i = 0; i < size; ++i) {
+    data[i] = static_cast<int8_t>(next_random());
+  }
+}
+
+void fill_random_bias(int channels) {
+  for (int i = 0; i < channels; ++i) {
+    bias_data[i] = static_cast<int32_t>(next_random() % 4096) - 2048;
+  }
+}
+
+int volume(const Dims3& dims) { return dims.h * dims.w * dims.c; }
+
+// Multiply-accumulates in one run of |shape|.
+uint64_t shape_macs(const LayerShape& shape) {
+  const uint64_t outputs = volume(shape.out);
+  const uint64_t window = shape.window.h * shape.window.w;
+  switch (shape.op) {
+    case kConv:
+      return outputs * window * shape.in.c;
+    case kDepthwise:
+      return outputs * window;
+    default:
+      return outputs * shape.in.c;
+  }
+}
+
+// Reduction depth of each output.
+int shape_depth(const LayerShape& shape) {
+  const int window = shape.window.h * shape.window.w;
+  switch (shape.op) {
+    case kConv:
+      return window * shape.in.c;
+    case kDepthwise:
+      return window;
+    default:
+      return shape.in.c;
+  }
+}
+
+int isqrt(int n) {
+  int root = 0;
+  while ((root + 1) * (root + 1) <= n) {
+    ++root;
+  }
+  return root;
+}
+
+// Keeps outputs of random data mostly inside int8 rather than saturated,
+// so that comparing outputs checks something.
+float output_scale(const LayerShape& shape) {
+  return kInputScale * kFilterScale * 128 * isqrt(shape_depth(shape));
+}
+
+// The models were converted with SAME or VALID padding, whichever gives the
+// recorded output size.
+TfLitePadding find_padding(const LayerShape& shape) {
+  int out_h = 0;
+  int out_w = 0;
+  tflite::ComputePaddingHeightWidth(
+      shape.stride.h, shape.stride.w, shape.dilation.h, shape.dilation.w,
+      shape.in.h, shape.in.w, shape.window.h, shape.window.w,
+      kTfLitePaddingSame, &out_h, &out_w);
+  return out_h == shape.out.h && out_w == shape.out.w ? kTfLitePaddingSame
+                                                      : kTfLitePaddingValid;
+}
+
+// Stock TFLM int8 ConvPerChannel, as it was before the TPU port.
+void stock_conv_per_channel(
+    const tflite::ConvParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const tflite::RuntimeShape& input_shape,
+    const int8_t* input_data, const tflite::RuntimeShape& filter_shape,
+    const int8_t* filter_data, const int32_t* bias_data,
+    const tflite::RuntimeShape& output_shape, int8_t* output_data) {
+  const int32_t input_offset = params.input_offset;
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  const int batches = input_shape.Dims(0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int filter_input_depth = filter_shape.Dims(3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = output_shape.Dims(3);
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          int32_t acc = 0;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+
+              // Zero padding by omitting the areas outside the image.
+              const bool is_point_inside_image =
+                  (in_x >= 0) && (in_x < input_width) && (in_y >= 0) &&
+                  (in_y < input_height);
+
+              if (!is_point_inside_image) {
+                continue;
+              }
+
+              for (int in_channel = 0; in_channel < filter_input_depth;
+                   ++in_channel) {
+                int32_t input_val = input_data[tflite::Offset(
+                    input_shape, batch, in_y, in_x, in_channel)];
+                int32_t filter_val = filter_data[tflite::Offset(
+                    filter_shape, out_channel, filter_y, filter_x, in_channel)];
+                acc += filter_val * (input_val + input_offset);
+              }
+            }
+          }
+
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          acc = tflite::MultiplyByQuantizedMultiplier(
+              acc, output_multiplier[out_channel], output_shift[out_channel]);
+          acc += output_offset;
+          acc = std::max(acc, output_activation_min);
+          acc = std::min(acc, output_activation_max);
+          output_data[tflite::Offset(output_shape, batch, out_y, out_x,
+                                     out_channel)] = static_cast<int8_t>(acc);
+        }
+      }
+    }
+  }
+}
+
+// Fastest of |runs| invocations, or 0 if the kernel failed.
+uint64_t time_kernel(tflite::micro::KernelRunner* runner, int runs) {
+  uint64_t fastest = 0;
+  for (int i = 0; i < runs; ++i) {
+    const uint64_t start = perf_get_mcycle64();
+    if (runner->Invoke() != kTfLiteOk) {
+      return 0;
+    }
+    const uint64_t cycles = perf_get_mcycle64() - start;
+    if (fastest == 0 || cycles < fastest) {
+      fastest = cycles;
+    }
+  }
+  return fastest;
+}
+
+// Per-tensor quantization of a filter, in the form the kernels expect.
+struct FilterQuantization {
+  // Leading counts, which FloatArrayFromFloats() overwrites with an int
+  float scales[2];
+  int zero_points[2];
+  TfLiteAffineQuantization params;
+};
+
+// Input, filter, bias and output tensors of one layer, backed by the static
+// buffers. |filter_quantization| must outlive the tensors.
+void make_tensors(const LayerShape& shape, int* input_dims, int* filter_dims,
+                  int* bias_dims, int* output_dims,
+                  FilterQuantization* filter_quantization,
+                  TfLiteTensor* tensors) {
+  filter_quantization->scales[0] = 1;
+  filter_quantization->scales[1] = kFilterScale;
+  filter_quantization->zero_points[0] = 1;
+  filter_quantization->zero_points[1] = 0;
+  filter_quantization->params.scale =
+      tflite::testing::FloatArrayFromFloats(filter_quantization->scales);
+  filter_quantization->params.zero_point =
+      tflite::testing::IntArrayFromInts(filter_quantization->zero_points);
+  filter_quantization->params.quantized_dimension =
+      shape.op == kDepthwise ? 3 : 0;
+
+  tensors[0] = tflite::testing::CreateQuantizedTensor(
+      input_data, tflite::testing::IntArrayFromInts(input_dims), kInputScale,
+      kInputZeroPoint);
+  tensors[1] = tflite::testing::CreateQuantizedTensor(
+      filter_data, tflite::testing::IntArrayFromInts(filter_dims),
+      kFilterScale, 0);
+  tensors[1].quantization = {kTfLiteAffineQuantization,
+                            &filter_quantization->params};
+  tensors[2] = tflite::testing::CreateQuantizedTensor(
+      bias_data, tflite::testing::IntArrayFromInts(bias_dims),
+      kInputScale * kFilterScale, 0);
+  tensors[3] = tflite::testing::CreateQuantizedTensor(
+      output_data, tflite::testing::IntArrayFromInts(output_dims),
+      output_scale(shape), kOutputZeroPoint);
+}
+
+// Fastest of |runs| invocations of |registration| on |shape|, or 0 if the
+// kernel would not prepare or run.
+uint64_t run_kernel(const LayerShape& shape,
+                    const TfLiteRegistration& registration, int* input_dims,
+                    int* filter_dims, int* bias_dims, int* output_dims,
+                    void* builtin_data, int runs) {
+  FilterQuantization filter_quantization;
+  TfLiteTensor tensors[4];
+  make_tensors(shape, input_dims, filter_dims, bias_dims, output_dims,
+               &filter_quantization, tensors);
+  int inputs[] = {3, 0, 1, 2};
+  int outputs[] = {1, 3};
+  tflite::micro::KernelRunner runner(
+      registration, tensors, 4, tflite::testing::IntArrayFromInts(inputs),
+      tflite::testing::IntArrayFromInts(outputs), builtin_data);
+  if (runner.InitAndPrepare() != kTfLiteOk) {
+    return 0;
+  }
+  return time_kernel(&runner, runs);
+}
+
+bool fits_tpu(const LayerShape& shape) {
+  return shape.out.h * shape.out.w <= kTpuMaxDim &&
+         shape_depth(shape) <= kTpuMaxDim && shape.out.c <= kTpuMaxDim;
+}
+
+Result bench_conv(const LayerShape& shape, int runs) {
+  Result result = {0, 0, "-"};
+  int input_dims[] = {4, 1, shape.in.h, shape.in.w, shape.in.c};
+  int filter_dims[] = {4, shape.out.c, shape.window.h, shape.window.w,
+                       shape.in.c};
+  int bias_dims[] = {1, shape.out.c};
+  int output_dims[] = {4, 1, shape.out.h, shape.out.w, shape.out.c};
+
+  TfLiteConvParams params = {};
+  params.padding = find_padding(shape);
+  params.stride_width = shape.stride.w;
+  params.stride_height = shape.stride.h;
+  params.activation = kTfLiteActNone;
+  params.dilation_width_factor = shape.dilation.w;
+  params.dilation_height_factor = shape.dilation.h;
+
+  // Stock reference, quantized as the kernel's Prepare does it
+  tflite::ConvParams op_params = {};
+  int out_h = 0;
+  int out_w = 0;
+  const TfLitePaddingValues padding = tflite::ComputePaddingHeightWidth(
+      shape.stride.h, shape.stride.w, shape.dilation.h, shape.dilation.w,
+      shape.in.h, shape.in.w, shape.window.h, shape.window.w, params.padding,
+      &out_h, &out_w);
+  op_params.padding_values.width = padding.width;
+  op_params.padding_values.height = padding.height;
+  op_params.input_offset = -kInputZeroPoint;
+  op_params.output_offset = kOutputZeroPoint;
+  op_params.stride_width = shape.stride.w;
+  op_params.stride_height = shape.stride.h;
+  op_params.dilation_width_factor = shape.dilation.w;
+  op_params.dilation_height_factor = shape.dilation.h;
+  op_params.quantized_activation_min = -128;
+  op_params.quantized_activation_max = 127;
+  int32_t multiplier = 0;
+  int shift = 0;
+  tflite::QuantizeMultiplier(static_cast<double>(kInputScale) *
+                                 static_cast<double>(kFilterScale) /
+                                 static_cast<double>(output_scale(shape)),
+                             &multiplier, &shift);
+  for (int i = 0; i < shape.out.c; ++i) {
+    output_multiplier[i] = multiplier;
+    output_shift[i] = shift;
+  }
+  const tflite::RuntimeShape input_shape(4, input_dims + 1);
+  const tflite::RuntimeShape filter_shape(4, filter_dims + 1);
+  const tflite::RuntimeShape output_shape(4, output_dims + 1);
+  for (int i = 0; i < runs; ++i) {
+    const uint64_t start = perf_get_mcycle64();
+    stock_conv_per_channel(op_params, output_multiplier, output_shift,
+                           input_shape, input_data, filter_shape, filter_data,
+                           bias_data, output_shape, stock_output_data);
+    const uint64_t cycles = perf_get_mcycle64() - start;
+    if (result.stock_cycles == 0 || cycles < result.stock_cycles) {
+      result.stock_cycles = cycles;
+    }
+  }
+
+  if (!fits_tpu(shape)) {
+    result.check = "too big";
+    return result;
+  }
+  const TfLiteRegistration registration = tflite::Register_CONV_2D();
+  result.kernel_cycles = run_kernel(shape, registration, input_dims,
+                                    filter_dims, bias_dims, output_dims,
+                                    &params, runs);
+  if (result.kernel_cycles == 0) {
+    result.check = "failed";
+  } else {
+    result.check = memcmp(output_data, stock_output_data, volume(shape.out))
+                       ? "MISMATCH"
+                       : "ok";
+  }
+  return result;
+}
+
+Result bench_depthwise(const LayerShape& shape, int runs) {
+  Result result = {0, 0, "-"};
+  int input_dims[] = {4, 1, shape.in.h, shape.in.w, shape.in.c};
+  int filter_dims[] = {4, 1, shape.window.h, shape.window.w, shape.out.c};
+  int bias_dims[] = {1, shape.out.c};
+  int output_dims[] = {4, 1, shape.out.h, shape.out.w, shape.out.c};
+
+  TfLiteDepthwiseConvParams params = {};
+  params.padding = find_padding(shape);
+  params.stride_width = shape.stride.w;
+  params.stride_height = shape.stride.h;
+  params.depth_multiplier = shape.out.c / shape.in.c;
+  params.activation = kTfLiteActNone;
+  params.dilation_width_factor = shape.dilation.w;
+  params.dilation_height_factor = shape.dilation.h;
+
+  const TfLiteRegistration registration = tflite::Register_DEPTHWISE_CONV_2D();
+  result.kernel_cycles = run_kernel(shape, registration, input_dims,
+                                    filter_dims, bias_dims, output_dims,
+                                    &params, runs);
+  if (result.kernel_cycles == 0) {
+    result.check = "failed";
+  }
+  return result;
+}
+
+// Batch matmul runs as a fully connected layer of the same rows, depth and
+// units, as there is no batch matmul kernel to time.
+Result bench_fully_connected(const LayerShape& shape, int runs) {
+  Result result = {0, 0, "-"};
+  int input_dims[] = {2, shape.in.h, shape.in.c};
+  int filter_dims[] = {2, shape.out.c, shape.in.c};
+  int bias_dims[] = {1, shape.out.c};
+  int output_dims[] = {2, shape.out.h, shape.out.c};
+
+  TfLiteFullyConnectedParams params = {};
+  params.activation = kTfLiteActNone;
+  params.weights_format = kTfLiteFullyConnectedWeightsFormatDefault;
+
+  const TfLiteRegistration registration = tflite::Register_FULLY_CONNECTED();
+  result.kernel_cycles = run_kernel(shape, registration, input_dims,
+                                    filter_dims, bias_dims, output_dims,
+                                    &params, runs);
+  if (result.kernel_cycles == 0) {
+    result.check = "failed";
+  }
+  return result;
+}
+
+bool fits_buffers(const LayerShape& shape) {
+  const int filter_bytes = shape.out.c * shape_depth(shape);
+  return volume(shape.in) <= kMaxActivationBytes &&
+         volume(shape.out) <= kMaxActivationBytes &&
+         filter_bytes <= kMaxFilterBytes && shape.out.c <= kMaxChannels;
+}
+
+const char* op_name(OpKind op) {
+  switch (op) {
+    case kConv:
+      return "CONV_2D";
+    case kDepthwise:
+      return "DEPTHWISE";
+    case kFullyConnected:
+      return "FC";
+    default:
+      return "BATCH_MATMUL";
+  }
+}
+
+// Prints num / den to two decimals in |width| characters, or "-".
+void print_ratio(uint64_t num, uint64_t den, int width) {
+  if (num == 0 || den == 0) {
+    printf(" %*s", width, "-");
+    return;
+  }
+  const uint64_t centi = num * 100 / den;
+  printf(" %*llu.%02llu", width - 3, centi / 100, centi % 100);
+}
+
+void print_cycles(uint64_t cycles) {
+  if (cycles == 0) {
+    printf(" | %12s", "-");
+  } else {
+    printf(" | %12llu", cycles);
+  }
+}
+
+void print_shape(const LayerShape& shape) {
+  char in[16];
+  char window[16];
+  char out[16];
+  if (shape.op == kConv || shape.op == kDepthwise) {
+    snprintf(in, sizeof(in), "%dx%dx%d", shape.in.h, shape.in.w, shape.in.c);
+    snprintf(window, sizeof(window),
+             shape.dilation.h * shape.dilation.w > 1 ? "%dx%d/%d:%d"
+                                                     : "%dx%d/%d",
+             shape.window.h, shape.window.w, shape.stride.h,
+             std::max(shape.dilation.h, shape.dilation.w));
+    snprintf(out, sizeof(out), "%dx%dx%d", shape.out.h, shape.out.w,
+             shape.out.c);
+  } else {
+    snprintf(in, sizeof(in), "%dx%d", shape.in.h, shape.in.c);
+    snprintf(window, sizeof(window), "-");
+    snprintf(out, sizeof(out), "%dx%d", shape.out.h, shape.out.c);
+  }
+  printf(" %-12s | %-9s | %4d | %-11s | %-8s | %-11s", op_name(shape.op),
+         shape.models, shape.uses, in, window, out);
+}
+
+}  // anonymous namespace
+
+extern "C" void do_layer_benchmarks() {
+  int runs = read_val("Runs per shape");
+  if (runs < 1) {
+    runs = 1;
+  }
+  printf("\nCycles are the fastest of %d runs. Kernel is the op this project "
+         "registers,\nStock the reference conv the TPU replaced. MACs/cyc is "
+         "the kernel's, or stock's\nwhere the kernel could not run. Window is "
+         "height x width / stride : dilation.\n",
+         runs);
+  printf("\n Op           | Models    | Uses | Input       | Window   |"
+         " Output      |         MACs |       Kernel |        Stock |"
+         " Speedup | MACs/cyc | Check\n");
+  printf("--------------+-----------+------+-------------+----------+"
+         "-------------+--------------+--------------+--------------+"
+         "---------+----------+---------\n");
+
+  // Conv layers both ran, weighted by uses
+  uint64_t kernel_total = 0;
+  uint64_t stock_total = 0;
+  for (const LayerShape& shape : kShapes) {
+    print_shape(shape);
+    const uint64_t macs = shape_macs(shape);
+    printf(" | %12llu", macs);
+    if (!fits_buffers(shape)) {
+      printf(" | too big for the benchmark buffers\n");
+      continue;
+    }
+    random_state = 0x2545f491;
+    fill_random(input_data, volume(shape.in));
+    fill_random(filter_data, shape.out.c * shape_depth(shape));
+    fill_random_bias(shape.out.c);
+
+    Result result;
+    switch (shape.op) {
+      case kConv:
+        result = bench_conv(shape, runs);
+        break;
+      case kDepthwise:
+        result = bench_depthwise(shape, runs);
+        break;
+      default:
+        result = bench_fully_connected(shape, runs);
+        break;
+    }
+    print_cycles(result.kernel_cycles);
+    print_cycles(result.stock_cycles);
+    printf(" |");
+    print_ratio(result.stock_cycles, result.kernel_cycles, 7);
+    printf(" |");
+    print_ratio(macs, result.kernel_cycles ? result.kernel_cycles
+                                           : result.stock_cycles,
+                8);
+    printf(" | %s\n", result.check);
+
+    if (result.kernel_cycles && result.stock_cycles) {
+      kernel_total += result.kernel_cycles * shape.uses;
+      stock_total += result.stock_cycles * shape.uses;
+    }
+  }
+  if (kernel_total > 0) {
+    printf("\nConv layers that ran both ways, weighted by uses: %llu kernel, "
+           "%llu stock cycles,\nspeedup",
+           kernel_total, stock_total);
+    print_ratio(stock_total, kernel_total, 4);
+    printf("\n");
+  }
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LAYER_BENCHMARKS_H
+#define LAYER_BENCHMARKS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Times every distinct layer shape of the bundled models on random data,
+// through the registered kernel and the stock reference
+void do_layer_benchmarks();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !LAYER_BENCHMARKS_H
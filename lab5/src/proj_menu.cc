@@ -19,7 +19,9 @@
 #include <stdio.h>
 
 #include "cfu.h"
+#include "layer_benchmarks.h"
 #include "menu.h"
+#include "perf_scope.h"
 
 namespace {
 
@@ -63,13 +65,24 @@ void do_exercise_cfu_op0(void) {
   printf("Performed %d comparisons", count);
 }
 
+// Named perf scopes, such as the phases of ConvPerChannel
+void do_print_perf_scopes(void) { perf_scope_print_report(); }
+
+void do_reset_perf_scopes(void) {
+  perf_scope_reset();
+  puts("Perf scopes zeroed");
+}
+
 struct Menu MENU = {
     "Project Menu",
     "project",
     {
         MENU_ITEM('0', "exercise cfu op0", do_exercise_cfu_op0),
+        MENU_ITEM('b', "benchmark model layer shapes", do_layer_benchmarks),
         MENU_ITEM('g', "grid cfu op0", do_grid_cfu_op0),
         MENU_ITEM('h', "say Hello", do_hello_world),
+        MENU_ITEM('p', "print perf scopes", do_print_perf_scopes),
+        MENU_ITEM('z', "zero perf scopes", do_reset_perf_scopes),
         MENU_END,
     },
 };
@@ -17,11 +17,155 @@
 #include <stdint.h>
 #include "software_cfu.h"
 
+// Software model of the TPU CFU in cfu.v / TPU.v.
+//
+// The op number is funct7 (cmd_payload_function_id[9:3]); funct3 is ignored
+// just like in cfu.v.
+//
+//    1  reset              8  write A[rs1] = rs2    14  read C[rs1][31:0]
+//    2  set K = rs1        9  read A[rs1]           15  read C[rs1][63:32]
+//    3  read K            10  write B[rs1] = rs2    16  read C[rs1][95:64]
+//    4  set M = rs1       11  read B[rs1]           17  read C[rs1][127:96]
+//    5  read M            12  run, returns comp_cnt
+//    6  set N = rs1       13  read busy
+//    7  read N
+//
+// Buffer A word (blk * K + k) holds A[4*blk .. 4*blk+3][k], row 0 in bits
+// [31:24]. Buffer B word (blk * K + k) holds B[k][4*blk .. 4*blk+3], column 0
+// in bits [31:24]. Buffer C word (blk_n * M + m) holds C[m][4*blk_n .. +3],
+// column 0 in bits [127:96].
+//
+// Ops that do not drive rsp_payload_outputs_0 in cfu.v return whatever the
+// previous op left there, and so does this model.
+
+namespace {
+
+constexpr int kAddrBits = 12;
+constexpr uint32_t kIndexMask = (1u << kAddrBits) - 1;
+
+uint32_t buffer_a[1 << kAddrBits];
+uint32_t buffer_b[1 << kAddrBits];
+uint32_t buffer_c[1 << kAddrBits][4];
+
+// Cfu registers (32 bits) and the TPU's 8-bit copies of them.
+uint32_t K, M, N;
+uint32_t K_reg, M_reg, N_reg;
+
+uint32_t rsp;
+uint32_t comp_cnt;
+
+inline int32_t lane(uint32_t word, int i) {
+  return static_cast<int8_t>(word >> (24 - 8 * i));
+}
+
+void tpu_latch_params() {
+  // TPU.v only latches K/M/N while the low byte of K is non-zero.
+  if ((K & 0xff) != 0) {
+    K_reg = K & 0xff;
+    M_reg = M & 0xff;
+    N_reg = N & 0xff;
+  }
+}
+
+void tpu_run() {
+  tpu_latch_params();
+  const uint32_t a_blocks = (M_reg + 3) / 4;
+  const uint32_t b_blocks = (N_reg + 3) / 4;
+  uint32_t idx_c = 0;
+
+  for (uint32_t blk_n = 0; blk_n < b_blocks; ++blk_n) {
+    const uint32_t idx_b = K_reg * blk_n;
+    for (uint32_t blk_m = 0; blk_m < a_blocks; ++blk_m) {
+      // The controller forces idx_a to 1 after every tile when K == 1.
+      const uint32_t idx_a = (K_reg == 1) ? (blk_m ? 1 : 0) : K_reg * blk_m;
+      const uint32_t rows =
+          (blk_m == a_blocks - 1 && (M_reg & 3)) ? (M_reg & 3) : 4;
+
+      uint32_t acc[4][4] = {};
+      for (uint32_t k = 0; k < K_reg; ++k) {
+        const uint32_t a = buffer_a[(idx_a + k) & kIndexMask];
+        const uint32_t b = buffer_b[(idx_b + k) & kIndexMask];
+        for (int r = 0; r < 4; ++r) {
+          for (int c = 0; c < 4; ++c) {
+            acc[r][c] += static_cast<uint32_t>(lane(a, r) * lane(b, c));
+          }
+        }
+      }
+
+      for (uint32_t r = 0; r < rows; ++r) {
+        uint32_t* out = buffer_c[idx_c++ & kIndexMask];
+        for (int c = 0; c < 4; ++c) {
+          out[c] = acc[r][c];
+        }
+      }
+
+      // IDLE + READ (K + 8) + WRITE (rows + 1) cycles per tile.
+      comp_cnt += 1 + (K_reg + 8) + (rows + 1);
+    }
+  }
+  comp_cnt += 1;  // FINISH
+}
+
+}  // anonymous namespace
+
 //
 // In this function, place C code to emulate your CFU. You can switch between
 // hardware and emulated CFU by setting the CFU_SOFTWARE_DEFINED DEFINE in
 // the Makefile.
 uint32_t software_cfu(int funct3, int funct7, uint32_t rs1, uint32_t rs2)
 {
-  return (funct3 & 1) ? rs2 : rs1;
+  (void)funct3;
+  const uint32_t index = rs1 & kIndexMask;
+
+  switch (funct7) {
+    case 1:
+      K = M = N = 0;
+      break;
+    case 2:
+      K = rs1;
+      break;
+    case 3:
+      rsp = K;
+      break;
+    case 4:
+      M = rs1;
+      break;
+    case 5:
+      rsp = M;
+      break;
+    case 6:
+      N = rs1;
+      break;
+    case 7:
+      rsp = N;
+      break;
+    case 8:
+      buffer_a[index] = rs2;
+      break;
+    case 9:
+      rsp = buffer_a[index];
+      break;
+    case 10:
+      buffer_b[index] = rs2;
+      break;
+    case 11:
+      rsp = buffer_b[index];
+      break;
+    case 12:
+      tpu_run();
+      rsp = comp_cnt;
+      break;
+    case 13:
+      rsp = 0;  // The model finishes inside op 12, so it is never busy.
+      break;
+    case 14:
+    case 15:
+    case 16:
+    case 17:
+      rsp = buffer_c[index][17 - funct7];
+      break;
+    default:
+      break;
+  }
+  return rsp;
 }
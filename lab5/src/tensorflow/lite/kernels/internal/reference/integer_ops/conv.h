@@ -18,7 +18,7 @@ limitations under the License.
 #include <algorithm>
 
 #include "cfu.h"
-#include "perf.h"
+#include "perf_scope.h"
 
 #include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/portable_tensor_utils.h"
@@ -135,7 +135,7 @@ inline void ConvPerChannel(
     const int8_t* filter_data, const RuntimeShape& bias_shape,
     const int32_t* bias_data, const RuntimeShape& output_shape,
     int8_t* output_data) {
-    perf_enable_counter(6);
+  PERF_SCOPE("conv");
   // Get parameters.
   const int32_t input_offset = params.input_offset;  // r = s(q - Z)
   const int stride_width = params.stride_width;
@@ -220,6 +220,7 @@ inline void ConvPerChannel(
     
 //  input_fmaps prepare : 3D to 2D
 
+    PERF_SCOPE_BEGIN("conv.im2col");
     for (int out_y = 0; out_y < output_height; ++out_y) {
       const int in_y_origin = (out_y * stride_height) - pad_height;
       for (int out_x = 0; out_x < output_width; ++out_x) {
@@ -255,10 +256,12 @@ inline void ConvPerChannel(
 	}
       }
     }
+    PERF_SCOPE_END();
 
 //----------------------------------------------------------------------------------------------------
 //  filter prepare : 4D to 2D
 
+PERF_SCOPE_BEGIN("conv.filter");
 for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
   for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
     for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
@@ -274,14 +277,18 @@ for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
     }
   }
 }
+PERF_SCOPE_END();
 //----------------------------------------------------------------------------------------------------
 
 //  matrix_multiply(matrix_input_fmaps, input_fmaps_num, input_fmaps_size, matrix_filter, filter_size, filter_num, matrix_result);
   // matrix_multiply2D( input_fmaps_num, input_fmaps_size,  filter_size, filter_num);
+ PERF_SCOPE_BEGIN("cfu.matmul");
  tiled_matrix_multiply2D_SIMD ( input_fmaps_num, input_fmaps_size,  filter_size, filter_num); 
+ PERF_SCOPE_END();
 //----------------------------------------------------------------------------------------------------
 
 
+  PERF_SCOPE_BEGIN("conv.requantize");
   for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
     for (int out_y = 0; out_y < output_height; ++out_y) {
       for (int out_x = 0; out_x < output_width; ++out_x) {
@@ -305,8 +312,8 @@ for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
         }
       }
     }
+    PERF_SCOPE_END();
   } // batch
-  perf_disable_counter(6);
 }  // ConvPerChannel
 
 inline void ConvPerChannelWithPackedInt4Weights(
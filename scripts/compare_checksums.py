@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# Copyright 2021 The CFU-Playground Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Finds the first node where two inferences of one model differ.
+
+Build with DEFINES += CHECKSUM_OUTPUTS, capture the console of an inference
+in a reference build (e.g. CFU_SOFTWARE_DEFINED, or the kernels before a
+change) and in the build under test, then
+
+  python3 scripts/compare_checksums.py reference.log test.log
+
+Outputs are matched by tensor index rather than node, so that a node fused
+into another in one build only leaves its intermediate tensors unmatched.
+Everything after the first differing node is usually just its consequence.
+Exits with 1 if any tensor differs.
+"""
+
+import argparse
+import sys
+
+BEGIN = "--- OUTPUT CHECKSUMS BEGIN ---"
+END = "--- OUTPUT CHECKSUMS END ---"
+
+
+class Output:
+
+    def __init__(self, node, op, tensor, size, checksum):
+        self.node = node
+        self.op = op
+        self.tensor = tensor
+        self.size = size
+        self.checksum = checksum
+
+
+def read_runs(path):
+    """Returns every checksum block of a capture, each a list of Outputs."""
+    runs = []
+    outputs = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line == BEGIN:
+                outputs = []
+            elif line == END and outputs is not None:
+                runs.append(outputs)
+                outputs = None
+            elif outputs is not None:
+                fields = line.split(",")
+                if len(fields) != 5 or not fields[0].isdigit():
+                    continue
+                node, op, tensor, size, checksum = fields
+                # Fused into another node: nothing of its own to compare.
+                if tensor == "-":
+                    continue
+                outputs.append(
+                    Output(int(node), op, int(tensor), int(size), checksum))
+    return runs
+
+
+def pick_run(runs, index, path):
+    if not runs:
+        sys.exit("%s has no output checksums. Was it built with "
+                 "CHECKSUM_OUTPUTS?" % path)
+    if not -len(runs) <= index < len(runs):
+        sys.exit("%s has %d inference(s), no --run %d" %
+                 (path, len(runs), index))
+    return runs[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.split("\n\n")[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("reference", help="console capture of the reference")
+    parser.add_argument("test", help="console capture of the build under test")
+    parser.add_argument("--run",
+                        type=int,
+                        default=-1,
+                        help="which inference of each capture to compare, "
+                        "from 0 (default: the last)")
+    parser.add_argument("--all",
+                        action="store_true",
+                        help="list every differing tensor, not just the first "
+                        "ten")
+    args = parser.parse_args()
+
+    reference = pick_run(read_runs(args.reference), args.run, args.reference)
+    test = pick_run(read_runs(args.test), args.run, args.test)
+    by_tensor = {output.tensor: output for output in reference}
+
+    same = 0
+    differing = []
+    only_test = []
+    for output in test:
+        expected = by_tensor.pop(output.tensor, None)
+        if expected is None:
+            only_test.append(output)
+        elif (expected.size, expected.checksum) == (output.size,
+                                                      output.checksum):
+            same += 1
+        else:
+            differing.append((expected, output))
+    only_reference = sorted(by_tensor.values(), key=lambda o: o.node)
+
+    print("%d tensors match, %d differ, %d only in the reference, %d only "
+          "under test" %
+          (same, len(differing), len(only_reference), len(only_test)))
+    if only_reference or only_test:
+        print("(Unmatched tensors are usually intermediates of a fused op.)")
+    if not differing:
+        return
+
+    first_ref, first = differing[0]
+    print("\nFirst difference: node %d (%s), tensor %d" %
+          (first.node, first.op, first.tensor))
+    if first_ref.op != first.op:
+        print("  reference wrote it from node %d (%s)" %
+              (first_ref.node, first_ref.op))
+
+    shown = differing if args.all else differing[:10]
+    print("\n Node | Op                   | Tensor |    Bytes | Reference "
+          "| Test")
+    print("------+----------------------+--------+----------+-----------"
+          "+---------")
+    for expected, output in shown:
+        size = (str(output.size) if expected.size == output.size else
+                "%d/%d" % (expected.size, output.size))
+        print(" %4d | %-20s | %6d | %8s | %-9s | %s" %
+              (output.node, output.op, output.tensor, size, expected.checksum,
+               output.checksum))
+    if len(shown) < len(differing):
+        print("and %d more (--all lists them)" %
+              (len(differing) - len(shown)))
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,29 @@
+# Copyright 2021 The CFU-Playground Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Sources shared by more than one lab (perf_scope, the tracing profiler and
+# its Chrome trace export, the latency benchmark and the model menus that
+# offer it), included from a lab's Makefile after proj.mk.
+# shared/src goes into build/src before proj.mk's build-dir copies the lab's
+# src/ overlay over it, so a lab can still replace a shared file with its own.
+# host.mk copies it the same way.
+
+SHARED_SRC_DIR := $(abspath $(dir $(lastword $(MAKEFILE_LIST))))/src
+
+.PHONY: shared-src
+shared-src:
+	@mkdir -p build/src
+	@tar -C $(SHARED_SRC_DIR) -cf - . | tar -C build/src -xf -
+
+build-dir: shared-src
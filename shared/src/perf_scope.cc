@@ -0,0 +1,223 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_scope.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "perf.h"
+
+namespace {
+
+// Id of a call site not yet registered, and of one the registry had no room
+// for.
+constexpr int kUnregistered = -1;
+constexpr int kNoScope = -2;
+
+constexpr int kCalibrationIterations = 1000;
+
+struct Scope {
+  const char* name;
+  unsigned calls;
+  uint64_t inclusive;
+  uint64_t exclusive;
+};
+
+// An open scope.
+struct Frame {
+  int id;
+  uint64_t start;
+  // Cycles spent in scopes opened inside this one, overhead included.
+  uint64_t children;
+  // From the open hook, for the close hook.
+  uint32_t hook_handle;
+};
+
+Scope scopes[PERF_SCOPE_MAX_SCOPES];
+int num_scopes = 0;
+// Call sites left out of the registry because it was full.
+int num_unregistered = 0;
+
+Frame stack[PERF_SCOPE_MAX_DEPTH];
+// Open scopes, including any beyond PERF_SCOPE_MAX_DEPTH.
+int depth = 0;
+
+bool calibrated = false;
+// Cycles a scope measures around nothing.
+unsigned inner_overhead = 0;
+// Cycles a scope adds to the scope it is in, besides what it measures.
+unsigned outer_overhead = 0;
+
+perf_scope_open_hook open_hook = nullptr;
+perf_scope_close_hook close_hook = nullptr;
+
+int register_scope(const char* name) {
+  for (int i = 0; i < num_scopes; ++i) {
+    if (strcmp(scopes[i].name, name) == 0) {
+      return i;
+    }
+  }
+  if (num_scopes == PERF_SCOPE_MAX_SCOPES) {
+    ++num_unregistered;
+    return kNoScope;
+  }
+  scopes[num_scopes] = {name, 0, 0, 0};
+  return num_scopes++;
+}
+
+void push(int id, uint32_t hook_handle) {
+  if (depth < PERF_SCOPE_MAX_DEPTH) {
+    Frame& frame = stack[depth++];
+    frame.id = id;
+    frame.children = 0;
+    frame.hook_handle = hook_handle;
+    // Stamped last so that the bookkeeping above is not measured.
+    frame.start = perf_get_mcycle64();
+  } else {
+    ++depth;
+  }
+}
+
+// Closes the innermost scope and returns the cycles it measured, or nullptr
+// if it was not tracked.
+const Frame* pop(uint64_t* cycles) {
+  const uint64_t now = perf_get_mcycle64();
+  if (depth == 0 || depth-- > PERF_SCOPE_MAX_DEPTH) {
+    return nullptr;
+  }
+  const Frame& frame = stack[depth];
+  const uint64_t elapsed = now - frame.start;
+  *cycles = elapsed > inner_overhead ? elapsed - inner_overhead : 0;
+  return &frame;
+}
+
+void print_cycles(uint64_t cycles) { printf(" | %12llu", cycles); }
+
+}  // anonymous namespace
+
+extern "C" void perf_scope_calibrate() {
+  inner_overhead = 0;
+  outer_overhead = 0;
+
+  // Warm up
+  for (int i = 0; i < kCalibrationIterations; i++) {
+    asm volatile(" nop ");
+  }
+
+  // Measure empty loop
+  uint64_t start = perf_get_mcycle64();
+  for (int i = 0; i < kCalibrationIterations; i++) {
+    asm volatile(" nop ");
+  }
+  const uint64_t loop_cycles = perf_get_mcycle64() - start;
+
+  // Measure scopes around a nop, as seen from inside and outside
+  uint64_t measured = 0;
+  start = perf_get_mcycle64();
+  for (int i = 0; i < kCalibrationIterations; i++) {
+    push(kNoScope, 0);
+    asm volatile(" nop ");
+    uint64_t cycles = 0;
+    pop(&cycles);
+    measured += cycles;
+  }
+  const uint64_t scope_cycles = perf_get_mcycle64() - start;
+
+  // A nop is about a cycle, which both loops spend.
+  inner_overhead = measured / kCalibrationIterations;
+  inner_overhead = inner_overhead > 1 ? inner_overhead - 1 : 0;
+  outer_overhead = scope_cycles > loop_cycles
+                       ? (scope_cycles - loop_cycles) / kCalibrationIterations
+                       : 0;
+  calibrated = true;
+}
+
+extern "C" void perf_scope_reset() {
+  if (!calibrated) {
+    perf_scope_calibrate();
+  }
+  for (int i = 0; i < num_scopes; ++i) {
+    scopes[i].calls = 0;
+    scopes[i].inclusive = 0;
+    scopes[i].exclusive = 0;
+  }
+  depth = 0;
+}
+
+extern "C" void perf_scope_begin(int* id, const char* name) {
+  if (*id == kUnregistered) {
+    if (!calibrated) {
+      perf_scope_calibrate();
+    }
+    *id = register_scope(name);
+  }
+  const uint32_t hook_handle =
+      open_hook != nullptr && depth < PERF_SCOPE_MAX_DEPTH ? open_hook(name)
+                                                            : 0;
+  push(*id, hook_handle);
+}
+
+extern "C" void perf_scope_end() {
+  uint64_t cycles = 0;
+  const Frame* frame = pop(&cycles);
+  if (frame == nullptr) {
+    return;
+  }
+  if (frame->id >= 0) {
+    Scope& scope = scopes[frame->id];
+    scope.calls++;
+    scope.inclusive += cycles;
+    scope.exclusive += cycles > frame->children ? cycles - frame->children : 0;
+  }
+  if (depth > 0) {
+    stack[depth - 1].children += cycles + outer_overhead;
+  }
+  if (close_hook != nullptr) {
+    close_hook(frame->hook_handle);
+  }
+}
+
+extern "C" void perf_scope_set_hooks(perf_scope_open_hook open,
+                                     perf_scope_close_hook close) {
+  open_hook = open;
+  close_hook = close;
+}
+
+extern "C" void perf_scope_print_report() {
+  printf("\n Scope                |    Calls |    Inclusive |    Exclusive |"
+         "      Average\n");
+  printf("----------------------+----------+--------------+--------------+"
+         "--------------\n");
+  for (int i = 0; i < num_scopes; ++i) {
+    const Scope& scope = scopes[i];
+    printf(" %-20s | %8u", scope.name, scope.calls);
+    print_cycles(scope.inclusive);
+    print_cycles(scope.exclusive);
+    print_cycles(scope.calls ? scope.inclusive / scope.calls : 0);
+    printf("\n");
+  }
+  printf("Less %u cycles inside and %u around each scope\n", inner_overhead,
+         outer_overhead);
+  if (num_unregistered > 0) {
+    printf("%d call sites over the limit of %d scopes were not counted\n",
+           num_unregistered, PERF_SCOPE_MAX_SCOPES);
+  }
+  if (depth != 0) {
+    printf("%d scopes still open\n", depth);
+  }
+}
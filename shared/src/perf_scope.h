@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Named, nestable cycle counting scopes
+ *
+ * Each scope is timed with mcycle rather than one of the 8 perf counters, so
+ * any number of call sites can be measured without agreeing on counter
+ * numbers. Call sites with the same name add up to one row of the report.
+ * Scopes nest: a scope's exclusive cycles leave out the scopes inside it, and
+ * the calibrated cost of starting and stopping a scope is taken off both.
+ *
+ *   C++:  { PERF_SCOPE("conv.im2col"); ... }
+ *   C:    PERF_SCOPE_BEGIN("conv.im2col"); ... PERF_SCOPE_END();
+ *
+ * Names starting with "cfu." mark spans where the CPU is driving or waiting
+ * on the CFU.
+ */
+
+#ifndef _PERF_SCOPE_H
+#define _PERF_SCOPE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Distinct scope names, and how deep scopes may nest, before they are ignored.
+#define PERF_SCOPE_MAX_SCOPES 32
+#define PERF_SCOPE_MAX_DEPTH 16
+
+// Measures the cycles a scope adds, inside and around itself. Done by
+// perf_scope_reset() the first time, so call either at boot rather than
+// inside a timed region.
+void perf_scope_calibrate(void);
+
+// Zeroes every scope, keeping their names.
+void perf_scope_reset(void);
+
+// Opens scope |name|. |*id| caches its registry slot and must start as -1.
+void perf_scope_begin(int* id, const char* name);
+
+// Closes the innermost open scope.
+void perf_scope_end(void);
+
+// Prints calls, inclusive and exclusive cycles for every scope.
+void perf_scope_print_report(void);
+
+// Called as each scope opens, with its name, and as it closes, with what the
+// open hook returned, e.g. to place scopes on a trace. Not timed as part of
+// the scope. Either may be NULL.
+typedef uint32_t (*perf_scope_open_hook)(const char* name);
+typedef void (*perf_scope_close_hook)(uint32_t handle);
+void perf_scope_set_hooks(perf_scope_open_hook open,
+                          perf_scope_close_hook close);
+
+#define PERF_SCOPE_BEGIN(name)                  \
+  do {                                          \
+    static int perf_scope_id_ = -1;             \
+    perf_scope_begin(&perf_scope_id_, (name));  \
+  } while (0)
+
+#define PERF_SCOPE_END() perf_scope_end()
+
+#ifdef __cplusplus
+}
+
+// Times the rest of the enclosing block.
+class PerfScope {
+ public:
+  PerfScope(int* id, const char* name) { perf_scope_begin(id, name); }
+  ~PerfScope() { perf_scope_end(); }
+
+  PerfScope(const PerfScope&) = delete;
+  PerfScope& operator=(const PerfScope&) = delete;
+};
+
+#define PERF_SCOPE_CONCAT_(a, b) a##b
+#define PERF_SCOPE_CONCAT(a, b) PERF_SCOPE_CONCAT_(a, b)
+#define PERF_SCOPE(name)                                               \
+  static int PERF_SCOPE_CONCAT(perf_scope_id_, __LINE__) = -1;         \
+  PerfScope PERF_SCOPE_CONCAT(perf_scope_, __LINE__)(                  \
+      &PERF_SCOPE_CONCAT(perf_scope_id_, __LINE__), (name))
+#endif
+
+#endif  // _PERF_SCOPE_H
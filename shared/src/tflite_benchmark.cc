@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SKIP_TFLM
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "perf.h"
+#include "tflite.h"
+
+namespace {
+
+constexpr int kMaxBenchmarkRuns = 1000;
+uint64_t benchmark_cycles[kMaxBenchmarkRuns];
+
+void print_benchmark_row(const char* name, uint64_t cycles) {
+  printf("  %-14s", name);
+  perf_print_value(cycles);
+  printf("\n");
+}
+
+}  // anonymous namespace
+
+void tflite_benchmark(void (*set_input)(int index), int num_inputs,
+                      int runs) {
+  runs = std::max(1, std::min(runs, kMaxBenchmarkRuns));
+  num_inputs = std::max(1, num_inputs);
+  tflite_set_quiet(true);
+
+  // A fresh interpreter, so that the first Invoke() pays for what kernels
+  // set up lazily, as it would after boot.
+  if (!tflite_reload_model()) {
+    tflite_set_quiet(false);
+    puts("No model loaded.");
+    return;
+  }
+  set_input(0);
+  const uint64_t cold = tflite_timed_invoke();
+  bool failed = cold == 0;
+
+  // One pass over the inputs to warm the caches up before timing.
+  for (int i = 1; i < num_inputs && !failed; ++i) {
+    set_input(i);
+    failed = tflite_timed_invoke() == 0;
+  }
+
+  uint64_t total = 0;
+  for (int i = 0; i < runs && !failed; ++i) {
+    set_input(i % num_inputs);
+    benchmark_cycles[i] = tflite_timed_invoke();
+    failed = benchmark_cycles[i] == 0;
+    total += benchmark_cycles[i];
+  }
+  tflite_set_quiet(false);
+  if (failed) {
+    puts("Invoke failed.");
+    return;
+  }
+
+  std::sort(benchmark_cycles, benchmark_cycles + runs);
+  // Nearest rank: the smallest sample at or above 99% of them.
+  const int p99 = (runs * 99 + 99) / 100 - 1;
+  const uint64_t median = benchmark_cycles[runs / 2];
+  printf("\n1 cold, %d warm-up and %d timed invocations over %d inputs\n",
+         num_inputs - 1, runs, num_inputs);
+  print_benchmark_row("cold", cold);
+  print_benchmark_row("min", benchmark_cycles[0]);
+  print_benchmark_row("median", median);
+  print_benchmark_row("p99", benchmark_cycles[p99]);
+  print_benchmark_row("max", benchmark_cycles[runs - 1]);
+  print_benchmark_row("mean", total / runs);
+  if (cold >= median) {
+    print_benchmark_row("cold - median", cold - median);
+  } else {
+    print_benchmark_row("median - cold", median - cold);
+  }
+}
+
+#endif  // SKIP_TFLM
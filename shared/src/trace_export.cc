@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_export.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Assumes 100 MHz
+constexpr uint64_t kCyclesPerMicrosecond = 100;
+
+const char* const kCfuPrefix = "cfu.";
+
+constexpr int kCpuTrack = 1;
+constexpr int kCfuTrack = 2;
+
+// Prints |cycles| as microseconds, exactly.
+void print_us(uint64_t cycles) {
+  printf("%llu.%02llu", cycles / kCyclesPerMicrosecond,
+         cycles % kCyclesPerMicrosecond);
+}
+
+void print_track_name(int track, const char* name) {
+  printf("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,"
+         "\"args\":{\"name\":\"%s\"}},\n",
+         track, name);
+}
+
+}  // anonymous namespace
+
+void trace_export_print(const TracingProfiler& profiler) {
+  const uint64_t origin =
+      profiler.num_events() > 0 ? profiler.event(0).start : 0;
+  // Node indices are only known when no node has been overwritten.
+  const bool known_nodes = profiler.num_dropped() == 0;
+
+  printf("\n" TRACE_EXPORT_BEGIN "\n");
+  printf("{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":%u},\n",
+         profiler.num_dropped());
+  printf("\"traceEvents\":[\n");
+  printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+         "\"args\":{\"name\":\"CFU Playground\"}},\n");
+  print_track_name(kCpuTrack, "CPU");
+  print_track_name(kCfuTrack, "CFU");
+
+  int node = 0;
+  uint64_t last_end = origin;
+  for (int i = 0; i < profiler.num_events(); ++i) {
+    const TraceEvent& event = profiler.event(i);
+    const bool is_node = event.depth == 0;
+    const bool is_cfu = strncmp(event.tag, kCfuPrefix, strlen(kCfuPrefix)) == 0;
+    if (event.end == 0) {
+      node += is_node;
+      continue;
+    }
+    printf("{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,"
+           "\"tid\":%d,\"ts\":",
+           event.tag, is_node ? "op" : is_cfu ? "cfu" : "scope",
+           is_cfu ? kCfuTrack : kCpuTrack);
+    print_us(event.start - origin);
+    printf(",\"dur\":");
+    print_us(event.cycles());
+    printf(",\"args\":{\"cycles\":%llu", event.cycles());
+    if (is_node && known_nodes) {
+      printf(",\"node\":%d", node);
+    }
+    printf("}},\n");
+    node += is_node;
+    if (event.end > last_end) {
+      last_end = event.end;
+    }
+  }
+  // JSON allows no trailing comma, so the list ends on a marker event.
+  printf("{\"ph\":\"i\",\"name\":\"end\",\"s\":\"g\",\"pid\":1,\"tid\":%d,"
+         "\"ts\":",
+         kCpuTrack);
+  print_us(last_end - origin);
+  printf("}\n]}\n");
+  printf(TRACE_EXPORT_END "\n");
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Chrome trace event export of an inference timeline
+ */
+#ifndef _TRACE_EXPORT_H
+#define _TRACE_EXPORT_H
+
+#ifndef __cplusplus
+#error "trace_export.h is for C++ only"
+#endif
+
+#include "tracing_profiler.h"
+
+// Lines around the JSON on the console. Cut it out of a captured session with
+//   sed -n '/^--- CHROME TRACE BEGIN ---/,/^--- CHROME TRACE END ---/p' |
+//     sed '1d;$d' > trace.json
+// and open it in chrome://tracing or ui.perfetto.dev.
+#define TRACE_EXPORT_BEGIN "--- CHROME TRACE BEGIN ---"
+#define TRACE_EXPORT_END "--- CHROME TRACE END ---"
+
+// Prints every ended event of |profiler| as a complete ("X") trace event,
+// timestamped in microseconds at 100 MHz with cycle resolution. Nodes carry
+// their index; scopes named "cfu.*" go on a CFU track of their own.
+void trace_export_print(const TracingProfiler& profiler);
+
+#endif  // _TRACE_EXPORT_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tracing_profiler.h"
+
+#include <stdio.h>
+
+#include "perf.h"
+
+uint32_t TracingProfiler::BeginEvent(const char* tag) {
+  const uint32_t handle = num_begun_++;
+  TraceEvent& event = events_[handle % kMaxEvents];
+  event.tag = tag;
+  event.end = 0;
+  num_nodes_ += depth_ == 0;
+  event.depth = depth_++;
+  // Stamped last so that the bookkeeping above is not part of the event.
+  event.start = perf_get_mcycle64();
+  return handle;
+}
+
+void TracingProfiler::EndEvent(uint32_t event_handle) {
+  const uint64_t now = perf_get_mcycle64();
+  const bool was_open = depth_ > 0;
+  if (was_open) {
+    --depth_;
+  }
+  if (num_begun_ - event_handle <= static_cast<uint32_t>(kMaxEvents)) {
+    events_[event_handle % kMaxEvents].end = now;
+  }
+  if (was_open && depth_ == 0 && node_end_hook_ != nullptr) {
+    node_end_hook_(num_nodes_ - 1);
+  }
+}
+
+void TracingProfiler::ClearEvents() {
+  num_begun_ = 0;
+  depth_ = 0;
+  num_nodes_ = 0;
+}
+
+int TracingProfiler::num_events() const {
+  return num_begun_ < static_cast<uint32_t>(kMaxEvents) ? num_begun_
+                                                         : kMaxEvents;
+}
+
+const TraceEvent& TracingProfiler::event(int i) const {
+  return events_[(num_dropped() + i) % kMaxEvents];
+}
+
+uint32_t TracingProfiler::num_dropped() const {
+  return num_begun_ - num_events();
+}
+
+void TracingProfiler::LogCsv() const {
+  if (num_dropped() > 0) {
+    printf("%u oldest events dropped\n", num_dropped());
+  }
+  printf("\"Event\",\"Tag\",\"Cycles\"\n");
+  for (int i = 0; i < num_events(); ++i) {
+    printf("%u,%s,%llu\n", num_dropped() + i, event(i).tag, event(i).cycles());
+  }
+}
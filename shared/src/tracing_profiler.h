@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 The CFU-Playground Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cycle-exact profiler for TfLM that does no I/O while events are recorded
+ */
+#include <stdint.h>
+
+#ifndef _TRACING_PROFILER_H
+#define _TRACING_PROFILER_H
+
+#ifndef __cplusplus
+#error "tracing_profiler.h is for C++ only"
+#endif
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+// One profiled span, in mcycle values.
+struct TraceEvent {
+  const char* tag;
+  uint64_t start;
+  // 0 until the event is ended.
+  uint64_t end;
+  // Number of events open when this one began: 0 for the nodes of the graph.
+  int depth;
+
+  uint64_t cycles() const { return end > start ? end - start : 0; }
+};
+
+// Stamps the 64-bit cycle counter at the start and end of every event into a
+// preallocated ring buffer, and nothing else: reporting is left to the caller
+// once Invoke() has returned. When more than kMaxEvents events begin between
+// two ClearEvents() calls, the oldest ones are overwritten.
+class TracingProfiler : public tflite::MicroProfilerInterface {
+ public:
+  static constexpr int kMaxEvents = 1024;
+
+  uint32_t BeginEvent(const char* tag) override;
+  void EndEvent(uint32_t event_handle) override;
+
+  void ClearEvents();
+
+  // Events still in the ring buffer, oldest first.
+  int num_events() const;
+  const TraceEvent& event(int i) const;
+
+  // Events begun since ClearEvents() that have been overwritten.
+  uint32_t num_dropped() const;
+
+  // Prints one row per event with its cycles, in the layout of
+  // MicroProfiler::LogCsv().
+  void LogCsv() const;
+
+  // Called with the node's index as each node of the graph ends, after its
+  // end is stamped, e.g. to look at what it wrote. May be nullptr.
+  typedef void (*NodeEndHook)(int node);
+  void set_node_end_hook(NodeEndHook hook) { node_end_hook_ = hook; }
+
+ private:
+  TraceEvent events_[kMaxEvents];
+  uint32_t num_begun_ = 0;
+  int depth_ = 0;
+  // Nodes begun since ClearEvents(), which no ring buffer wrap forgets.
+  int num_nodes_ = 0;
+  NodeEndHook node_end_hook_ = nullptr;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+#endif  // _TRACING_PROFILER_H